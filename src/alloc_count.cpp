@@ -0,0 +1,22 @@
+#include "alloc_count.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Per thread, so a thread only sees its own allocations and counting needs
+// no atomics
+static thread_local uint64_t allocations;
+
+uint64_t thread_allocations() { return allocations; }
+
+void *operator new(std::size_t size) {
+  allocations++;
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
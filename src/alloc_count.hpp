@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+// Calls to global operator new made so far on the calling thread. Counted
+// by the replacement operator new in alloc_count.cpp, which the game and
+// the fuzz tests link in. The headless library and tools keep the standard
+// one.
+uint64_t thread_allocations();
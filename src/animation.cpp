@@ -0,0 +1,55 @@
+#include "animation.hpp"
+
+#include <algorithm>
+#include <vector>
+
+static std::vector<uint16_t> schedules[SPRITE_COUNT];
+
+void build_animations() {
+  for (int id = 0; id < SPRITE_COUNT; id++) {
+    const AtlasSprite *sprite = &atlas.sprites[id];
+    int frame_ticks = std::max<int>(sprite->frame_ticks, 1);
+
+    schedules[id].resize(sprite->frame_count * frame_ticks);
+    for (int t = 0; t < (int)schedules[id].size(); t++) {
+      schedules[id][t] = sprite->first_frame + t / frame_ticks;
+    }
+  }
+}
+
+int animation_frame(SpriteId id, uint64_t age_ticks) {
+  return schedules[id][age_ticks % schedules[id].size()];
+}
+
+int animation_length(SpriteId id) { return schedules[id].size(); }
+
+void explosions_spawn(Explosions *explosions, float x, float y,
+                      uint64_t tick) {
+  if (explosions->count == MAX_EXPLOSIONS) {
+    explosions->head = explosion_slot(explosions, 1);
+    explosions->count--;
+  }
+
+  int slot = explosion_slot(explosions, explosions->count);
+  explosions->x[slot] = x;
+  explosions->y[slot] = y;
+  explosions->spawn_tick[slot] = tick;
+  explosions->frame[slot] = schedules[SPRITE_EXPLOSION][0];
+  explosions->count++;
+}
+
+void explosions_animate(Explosions *explosions, uint64_t tick) {
+  const std::vector<uint16_t> &schedule = schedules[SPRITE_EXPLOSION];
+  uint64_t length = schedule.size();
+
+  while (explosions->count > 0 &&
+         tick - explosions->spawn_tick[explosions->head] >= length) {
+    explosions->head = explosion_slot(explosions, 1);
+    explosions->count--;
+  }
+
+  for (int i = 0; i < explosions->count; i++) {
+    int slot = explosion_slot(explosions, i);
+    explosions->frame[slot] = schedule[tick - explosions->spawn_tick[slot]];
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#include "atlas.hpp"
+
+#define MAX_EXPLOSIONS 64
+
+// Frame schedules are expanded from the atlas once at startup: entry t of a
+// sprite's schedule is the atlas frame shown t ticks after it started, so
+// evaluating an animation is a single table lookup.
+void build_animations();
+
+// Frame of a looping animation
+int animation_frame(SpriteId id, uint64_t age_ticks);
+
+// Ticks a one-shot animation runs before it expires
+int animation_length(SpriteId id);
+
+// Explosions all last the same number of ticks, so they expire in the
+// order they were spawned. They live in a ring buffer in SoA form and are
+// retired from the head without moving the others.
+struct Explosions {
+  float x[MAX_EXPLOSIONS];
+  float y[MAX_EXPLOSIONS];
+  uint64_t spawn_tick[MAX_EXPLOSIONS];
+  uint16_t frame[MAX_EXPLOSIONS];
+  int head;
+  int count;
+};
+
+// Index of the i-th oldest explosion
+inline int explosion_slot(const Explosions *explosions, int i) {
+  return (explosions->head + i) % MAX_EXPLOSIONS;
+}
+
+// When the ring is full the oldest explosion is replaced
+void explosions_spawn(Explosions *explosions, float x, float y,
+                      uint64_t tick);
+
+// Retires expired explosions, then updates the frame of every live one
+void explosions_animate(Explosions *explosions, uint64_t tick);
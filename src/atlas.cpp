@@ -0,0 +1,37 @@
+#include "atlas.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+Atlas atlas;
+
+bool load_atlas(const char *path) {
+  FILE *file = fopen(path, "rb");
+
+  if (!file) {
+    std::cout << "Failed to open " << path << std::endl;
+    return false;
+  }
+
+  bool ok = fread(&atlas.header, sizeof(AtlasHeader), 1, file) == 1 &&
+            memcmp(atlas.header.magic, ATLAS_MAGIC, 4) == 0 &&
+            atlas.header.version == ATLAS_VERSION &&
+            atlas.header.sprite_count == SPRITE_COUNT;
+
+  if (ok) {
+    atlas.sprites.resize(atlas.header.sprite_count);
+    atlas.frames.resize(atlas.header.frame_count);
+    ok = fread(atlas.sprites.data(), sizeof(AtlasSprite), atlas.sprites.size(),
+               file) == atlas.sprites.size() &&
+         fread(atlas.frames.data(), sizeof(AtlasFrame), atlas.frames.size(),
+               file) == atlas.frames.size();
+  }
+
+  fclose(file);
+
+  if (!ok) {
+    std::cout << "Invalid or outdated atlas " << path << std::endl;
+  }
+  return ok;
+}
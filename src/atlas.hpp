@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#define SPRITE_SIZE 16
+
+#define ATLAS_MAGIC "SIAT"
+#define ATLAS_VERSION 1
+
+// Alien sprites follow the order of AlienTypeEnum
+enum SpriteId {
+  SPRITE_SHIP,
+  SPRITE_ALIEN_CYAN,
+  SPRITE_ALIEN_RED,
+  SPRITE_ALIEN_YELLOW,
+  SPRITE_ALIEN_WHITE,
+  SPRITE_PROJECTILE,
+  SPRITE_EXPLOSION,
+  SPRITE_BARRIER,
+  SPRITE_COUNT
+};
+
+// On-disk layout of atlas.bin, written by tools/atlas_packer.cpp. All
+// fields are little endian 16-bit values so the structs have no padding:
+// one AtlasHeader, sprite_count AtlasSprite and frame_count AtlasFrame.
+struct AtlasHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t sprite_count;
+  uint16_t frame_count;
+  uint16_t width;
+  uint16_t height;
+};
+
+struct AtlasSprite {
+  uint16_t first_frame;
+  uint16_t frame_count;
+  // Ticks each animation frame is shown, 0 for still sprites
+  uint16_t frame_ticks;
+};
+
+// A trimmed frame. x, y, w and h locate it in the atlas, offset places it
+// relative to the origin of the 16x16 cell it was cut from. Bit x of
+// mask[y] is set when cell pixel (x, y) is opaque.
+struct AtlasFrame {
+  uint16_t x, y, w, h;
+  int16_t offset_x, offset_y;
+  uint16_t mask[SPRITE_SIZE];
+};
+
+struct Atlas {
+  AtlasHeader header;
+  std::vector<AtlasSprite> sprites;
+  std::vector<AtlasFrame> frames;
+};
+
+extern Atlas atlas;
+
+bool load_atlas(const char *path);
@@ -0,0 +1,100 @@
+#include "audio.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Square wave sweeping from start_hz to end_hz with a linear fade out
+static void synth_sweep(std::vector<int16_t> *out, float seconds,
+                        float start_hz, float end_hz, int amplitude) {
+  int length = seconds * AUDIO_RATE;
+  out->resize(length);
+  float phase = 0;
+  for (int i = 0; i < length; i++) {
+    float t = float(i) / length;
+    phase += (start_hz + (end_hz - start_hz) * t) / AUDIO_RATE;
+    phase -= std::floor(phase);
+    (*out)[i] = (phase < 0.5f ? amplitude : -amplitude) * (1 - t);
+  }
+}
+
+// Noise held for hold samples at a time, which lowers its pitch
+static void synth_noise(std::vector<int16_t> *out, float seconds, int hold,
+                        int amplitude) {
+  int length = seconds * AUDIO_RATE;
+  out->resize(length);
+  uint32_t seed = 0x1234567;
+  int16_t value = 0;
+  for (int i = 0; i < length; i++) {
+    if (i % hold == 0) {
+      seed = seed * 1664525 + 1013904223;
+      value = int16_t((seed >> 16) % (2 * amplitude + 1)) - amplitude;
+    }
+    float t = float(i) / length;
+    (*out)[i] = value * (1 - t) * (1 - t);
+  }
+}
+
+void audio_build_bank(AudioEngine *audio) {
+  synth_sweep(&audio->bank[SOUND_SHOOT], 0.15f, 1200, 300, 6000);
+  synth_noise(&audio->bank[SOUND_ALIEN_EXPLOSION], 0.3f, 3, 8000);
+  synth_noise(&audio->bank[SOUND_SHIP_EXPLOSION], 0.8f, 8, 10000);
+
+  // Four falling bass notes for the march
+  static const float march_hz[] = {110, 98, 87.3f, 82.4f};
+  for (int i = 0; i < 4; i++) {
+    synth_sweep(&audio->bank[SOUND_MARCH_1 + i], 0.08f, march_hz[i],
+                march_hz[i], 7000);
+  }
+
+  for (Voice &voice : audio->voices) {
+    voice = {};
+  }
+}
+
+static void audio_start_voice(AudioEngine *audio, AudioCommand command) {
+  const std::vector<int16_t> &samples = audio->bank[command.sound];
+
+  // A free voice, or else the one closest to finishing
+  Voice *target = &audio->voices[0];
+  for (Voice &voice : audio->voices) {
+    if (!voice.samples) {
+      target = &voice;
+      break;
+    }
+    if (voice.length - voice.position <
+        target->length - target->position) {
+      target = &voice;
+    }
+  }
+
+  *target = {samples.data(), int(samples.size()), 0, command.volume};
+}
+
+void audio_mix(AudioEngine *audio, int16_t *out, int frames) {
+  AudioCommand command;
+  while (audio->commands.pop(&command)) {
+    audio_start_voice(audio, command);
+  }
+
+  for (int i = 0; i < frames; i++) {
+    int32_t sum = 0;
+    for (Voice &voice : audio->voices) {
+      if (voice.samples) {
+        sum += voice.samples[voice.position] * voice.volume >> 8;
+        if (++voice.position == voice.length) {
+          voice.samples = NULL;
+        }
+      }
+    }
+    out[i] = std::clamp<int32_t>(sum, INT16_MIN, INT16_MAX);
+  }
+}
+
+void audio_play(AudioEngine *audio, SoundId sound, int volume) {
+  if (!audio->device) {
+    return;
+  }
+  if (!audio->commands.push({uint8_t(sound), uint8_t(volume)})) {
+    audio->dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "sound.hpp"
+#include "spsc_queue.hpp"
+
+#define AUDIO_RATE 22050
+#define AUDIO_BUFFER_FRAMES 512
+#define AUDIO_VOICES 16
+#define AUDIO_COMMANDS 64
+
+struct AudioCommand {
+  uint8_t sound;
+  uint8_t volume;
+};
+
+struct Voice {
+  const int16_t *samples;
+  int length;
+  int position;
+  int volume;
+};
+
+// Mono 16-bit mixer running in the SDL audio callback. The game thread
+// posts commands through a lock-free queue. The callback drains it, starts
+// voices from the sample bank and mixes. Nothing on the audio thread
+// allocates or locks. The bank is synthesized before the device opens and
+// never changes afterwards.
+struct AudioEngine {
+  // SDL_AudioDeviceID, 0 while no device is open. Kept as a plain integer
+  // so the mixer builds without SDL, see audio_device.cpp.
+  uint32_t device;
+  SpscQueue<AudioCommand, AUDIO_COMMANDS> commands;
+  Voice voices[AUDIO_VOICES];
+  std::vector<int16_t> bank[SOUND_COUNT];
+  std::atomic<uint64_t> dropped{0};
+};
+
+// Builds the sample bank, without touching SDL
+void audio_build_bank(AudioEngine *audio);
+
+// Builds the bank and opens the default device. Run with
+// SDL_AUDIODRIVER=dummy to exercise the callback without sound hardware.
+bool audio_open(AudioEngine *audio);
+
+void audio_close(AudioEngine *audio);
+
+// Game thread. volume is 0 to 255.
+void audio_play(AudioEngine *audio, SoundId sound, int volume = 255);
+
+// The callback body: applies queued commands and mixes frames samples
+// into out. Callable directly to test the mixer without a device.
+void audio_mix(AudioEngine *audio, int16_t *out, int frames);
@@ -0,0 +1,46 @@
+#include "audio.hpp"
+
+#include <iostream>
+
+#include <SDL2/SDL.h>
+
+static void audio_callback(void *userdata, Uint8 *stream, int len) {
+  audio_mix((AudioEngine *)userdata, (int16_t *)stream,
+            len / sizeof(int16_t));
+}
+
+bool audio_open(AudioEngine *audio) {
+  audio_build_bank(audio);
+
+  if (SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+    std::cout << "Failed to initialize audio: " << SDL_GetError()
+              << std::endl;
+    return false;
+  }
+
+  SDL_AudioSpec want = {};
+  want.freq = AUDIO_RATE;
+  want.format = AUDIO_S16SYS;
+  want.channels = 1;
+  want.samples = AUDIO_BUFFER_FRAMES;
+  want.callback = audio_callback;
+  want.userdata = audio;
+
+  // SDL converts if the device wants another format
+  audio->device = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+  if (!audio->device) {
+    std::cout << "Failed to open audio device: " << SDL_GetError()
+              << std::endl;
+    return false;
+  }
+
+  SDL_PauseAudioDevice(audio->device, 0);
+  return true;
+}
+
+void audio_close(AudioEngine *audio) {
+  if (audio->device) {
+    SDL_CloseAudioDevice(audio->device);
+    audio->device = 0;
+  }
+}
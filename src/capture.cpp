@@ -0,0 +1,222 @@
+#include "capture.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+// Palette index of color, adding it while there is room. Past 256 colours
+// the closest existing entry is used, which this game never needs.
+static uint8_t capture_color(Capture *capture, uint32_t color) {
+  auto it = capture->colors.find(color);
+  if (it != capture->colors.end()) {
+    return it->second;
+  }
+
+  if (capture->palette.size() < CAPTURE_PALETTE) {
+    uint8_t index = capture->palette.size();
+    capture->palette.push_back(color);
+    capture->colors[color] = index;
+    return index;
+  }
+
+  int best = 0;
+  int best_distance = INT32_MAX;
+  for (int i = 0; i < CAPTURE_PALETTE; i++) {
+    int distance = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      int d = int((color >> shift) & 0xFF) -
+              int((capture->palette[i] >> shift) & 0xFF);
+      distance += d * d;
+    }
+    if (distance < best_distance) {
+      best = i;
+      best_distance = distance;
+    }
+  }
+  capture->colors[color] = best;
+  return best;
+}
+
+static void capture_encode(Capture *capture, bool key) {
+  const uint8_t *current = capture->current.data();
+  const uint8_t *previous = capture->previous.data();
+  std::vector<uint8_t> &out = capture->payload;
+  out.clear();
+
+  auto unchanged = [&](int i) { return !key && current[i] == previous[i]; };
+  auto repeat = [&](int i) {
+    int n = 1;
+    while (i + n < FRAME_PIXELS && n < 64 && current[i + n] == current[i]) {
+      n++;
+    }
+    return n;
+  };
+
+  int i = 0;
+  while (i < FRAME_PIXELS) {
+    if (unchanged(i)) {
+      int n = 1;
+      while (i + n < FRAME_PIXELS && n < 128 && unchanged(i + n)) {
+        n++;
+      }
+      out.push_back(n - 1);
+      i += n;
+      continue;
+    }
+
+    int n = repeat(i);
+    if (n >= 3) {
+      out.push_back(0x7F + n);
+      out.push_back(current[i]);
+      i += n;
+      continue;
+    }
+
+    // Literals up to the next skip or worthwhile run
+    int start = i;
+    while (i < FRAME_PIXELS && i - start < 64 && !unchanged(i) &&
+           (i == start || repeat(i) < 3)) {
+      i++;
+    }
+    out.push_back(0xBF + (i - start));
+    out.insert(out.end(), current + start, current + i);
+  }
+}
+
+static void capture_write_frame(Capture *capture, const uint32_t *pixels,
+                                uint64_t tick) {
+  bool key = capture->frames % CAPTURE_KEYFRAME_INTERVAL == 0;
+  int first_color = capture->palette.size();
+
+  for (int i = 0; i < FRAME_PIXELS; i++) {
+    capture->current[i] = capture_color(capture, pixels[i]);
+  }
+  capture_encode(capture, key);
+
+  if (key) {
+    first_color = 0;
+    capture->index.push_back({capture->frames, (uint64_t)ftell(capture->file)});
+  }
+
+  CaptureRecord record = {};
+  int color_count = capture->palette.size() - first_color;
+  record.size = color_count * sizeof(uint32_t) + capture->payload.size();
+  record.flags = key ? CAPTURE_FLAG_KEY : 0;
+  record.frame = capture->frames;
+  record.tick = tick;
+  record.first_color = first_color;
+  record.color_count = color_count;
+
+  fwrite(&record, sizeof(record), 1, capture->file);
+  fwrite(capture->palette.data() + first_color, sizeof(uint32_t), color_count,
+         capture->file);
+  fwrite(capture->payload.data(), 1, capture->payload.size(), capture->file);
+  if (key) {
+    fflush(capture->file);
+  }
+
+  capture->previous.swap(capture->current);
+  capture->frames++;
+}
+
+static void capture_loop(Capture *capture) {
+  while (true) {
+    capture->queued.acquire();
+
+    uint64_t tail = capture->tail.load(std::memory_order_relaxed);
+    if (tail == capture->head.load(std::memory_order_acquire)) {
+      // Woken up by capture_stop with nothing left to encode
+      if (!capture->running.load(std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+
+    int slot = tail % CAPTURE_QUEUE;
+    raster_draw_list(&capture->slots[slot], capture->sheet,
+                     capture->sheet_width, capture->pixels.data());
+    capture_write_frame(capture, capture->pixels.data(),
+                        capture->slot_ticks[slot]);
+    capture->tail.store(tail + 1, std::memory_order_release);
+  }
+}
+
+bool capture_start(Capture *capture, const char *path, const uint32_t *sheet,
+                   int sheet_width) {
+  if (capture->running.load()) {
+    return false;
+  }
+
+  capture->file = fopen(path, "wb");
+  if (!capture->file) {
+    std::cout << "Failed to open capture file " << path << std::endl;
+    return false;
+  }
+
+  CaptureHeader header = {};
+  memcpy(header.magic, CAPTURE_MAGIC, 4);
+  header.version = CAPTURE_VERSION;
+  header.width = SCREEN_WIDTH;
+  header.height = SCREEN_HEIGHT;
+  header.keyframe_interval = CAPTURE_KEYFRAME_INTERVAL;
+  fwrite(&header, sizeof(header), 1, capture->file);
+
+  // Everything the game thread touches is allocated up front
+  capture->slots.resize(CAPTURE_QUEUE);
+  capture->sheet = sheet;
+  capture->sheet_width = sheet_width;
+  capture->pixels.assign(FRAME_PIXELS, 0);
+  capture->previous.assign(FRAME_PIXELS, 0);
+  capture->current.assign(FRAME_PIXELS, 0);
+  capture->payload.reserve(FRAME_PIXELS * 2);
+  capture->palette.clear();
+  capture->colors.clear();
+  capture->index.clear();
+  capture->frames = 0;
+
+  capture->running.store(true);
+  capture->encoder = new std::thread(capture_loop, capture);
+  return true;
+}
+
+DrawList *capture_begin(Capture *capture) {
+  uint64_t head = capture->head.load(std::memory_order_relaxed);
+  if (head - capture->tail.load(std::memory_order_acquire) == CAPTURE_QUEUE) {
+    capture->dropped.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+  return &capture->slots[head % CAPTURE_QUEUE];
+}
+
+void capture_submit(Capture *capture, uint64_t tick) {
+  uint64_t head = capture->head.load(std::memory_order_relaxed);
+  capture->slot_ticks[head % CAPTURE_QUEUE] = tick;
+  capture->head.store(head + 1, std::memory_order_release);
+  capture->queued.release();
+}
+
+void capture_stop(Capture *capture) {
+  if (!capture->running.load()) {
+    return;
+  }
+
+  capture->running.store(false);
+  capture->queued.release();
+  capture->encoder->join();
+  delete capture->encoder;
+  capture->encoder = NULL;
+
+  uint64_t index_offset = ftell(capture->file);
+  uint32_t count = capture->index.size();
+  fwrite(&count, sizeof(count), 1, capture->file);
+  fwrite(capture->index.data(), sizeof(CaptureIndexEntry), count,
+         capture->file);
+
+  fseek(capture->file, offsetof(CaptureHeader, index_offset), SEEK_SET);
+  fwrite(&index_offset, sizeof(index_offset), 1, capture->file);
+  fclose(capture->file);
+  capture->file = NULL;
+
+  std::cout << "Captured " << capture->frames << " frames, dropped "
+            << capture->dropped.load() << std::endl;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <semaphore>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "raster.hpp"
+
+#define CAPTURE_MAGIC "SICP"
+#define CAPTURE_VERSION 1
+#define CAPTURE_KEYFRAME_INTERVAL 60
+#define CAPTURE_QUEUE 16
+#define CAPTURE_PALETTE 256
+
+#define CAPTURE_FLAG_KEY 1
+
+// A capture file is a CaptureHeader, one record per frame and, once the
+// capture is closed, an index of the keyframes at header.index_offset.
+// Records are self delimiting so a file cut short by a crash can still be
+// played up to the last whole record.
+//
+// Every pixel is an index into a palette that only grows. A record carries
+// the palette entries added since the previous record (all of them on a
+// keyframe) followed by the RLE coded indices, top row first:
+//   0x00-0x7F  skip c + 1 pixels unchanged from the previous frame
+//   0x80-0xBF  repeat the next byte c - 0x7F times
+//   0xC0-0xFF  copy the next c - 0xBF bytes
+// Keyframes never skip, so decoding can start at any of them.
+struct CaptureHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t keyframe_interval;
+  uint32_t reserved;
+  uint64_t index_offset;
+};
+
+struct CaptureRecord {
+  uint32_t size;
+  uint32_t flags;
+  uint64_t frame;
+  uint64_t tick;
+  uint16_t first_color;
+  uint16_t color_count;
+  uint32_t reserved;
+};
+
+struct CaptureIndexEntry {
+  uint64_t frame;
+  uint64_t offset;
+};
+
+// Decodes one record payload on top of the previous frame's indices
+inline bool capture_decode(const uint8_t *data, size_t size,
+                           uint8_t *indices) {
+  const uint8_t *end = data + size;
+  int i = 0;
+  while (i < FRAME_PIXELS && data < end) {
+    int c = *data++;
+    if (c < 0x80) {
+      i += c + 1;
+    } else if (c < 0xC0) {
+      int n = c - 0x7F;
+      if (data == end || i + n > FRAME_PIXELS) {
+        return false;
+      }
+      for (int k = 0; k < n; k++) {
+        indices[i++] = *data;
+      }
+      data++;
+    } else {
+      int n = c - 0xBF;
+      if (end - data < n || i + n > FRAME_PIXELS) {
+        return false;
+      }
+      for (int k = 0; k < n; k++) {
+        indices[i++] = *data++;
+      }
+    }
+  }
+  return i == FRAME_PIXELS && data == end;
+}
+
+// Records frames to a file. The game copies the draw list of a frame into
+// a preallocated slot and a background thread rasterizes, encodes and
+// writes it. When the encoder falls behind frames are dropped rather than
+// stalling the game.
+struct Capture {
+  FILE *file;
+  std::thread *encoder;
+  std::atomic<bool> running{false};
+
+  // Single producer, single consumer queue of frame slots
+  std::vector<DrawList> slots;
+  uint64_t slot_ticks[CAPTURE_QUEUE];
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint64_t> tail{0};
+  // One count per queued frame plus one to wake the encoder on stop
+  std::counting_semaphore<CAPTURE_QUEUE + 1> queued{0};
+  std::atomic<uint64_t> dropped{0};
+
+  // Encoder thread only
+  const uint32_t *sheet;
+  int sheet_width;
+  std::vector<uint32_t> pixels;
+  std::vector<uint32_t> palette;
+  std::unordered_map<uint32_t, uint8_t> colors;
+  std::vector<uint8_t> previous;
+  std::vector<uint8_t> current;
+  std::vector<uint8_t> payload;
+  std::vector<CaptureIndexEntry> index;
+  uint64_t frames;
+};
+
+// Opens path and starts the encoder thread, which draws frames from the
+// atlas image sheet as raster_frame() takes it
+bool capture_start(Capture *capture, const char *path, const uint32_t *sheet,
+                   int sheet_width);
+
+// Slot for the next frame, or NULL when the queue is full. Fill it with
+// draw_list_build().
+DrawList *capture_begin(Capture *capture);
+
+// Queues the frame written to the slot from capture_begin
+void capture_submit(Capture *capture, uint64_t tick);
+
+// Encodes what is still queued, writes the index and closes the file
+void capture_stop(Capture *capture);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+
+#include "atlas.hpp"
+#include "ecs.hpp"
+
+#define ROWS_PER_WORD (64 / SPRITE_SIZE)
+#define BARRIER_WORDS (SPRITE_SIZE / ROWS_PER_WORD)
+
+enum AlienTypeEnum { CYAN, RED, YELLOW, WHITE };
+
+enum Move { LEFT, RIGHT, DOWN };
+
+struct Vector2f {
+  float x = 0;
+  float y = 0;
+};
+
+struct Vector2i {
+  int x = 0;
+  int y = 0;
+};
+
+struct Box2f {
+  Vector2f min;
+  Vector2f max;
+};
+
+struct Position : Vector2f {};
+
+// Position at the start of the last tick, render() draws in between
+struct PrevPosition : Vector2f {};
+
+struct Velocity : Vector2f {};
+
+struct Sprite {
+  SpriteId id;
+};
+
+// Aliens start in a grid, index is row * ALIEN_COLUMNS + column with row 0
+// closest to the ship
+#define ALIEN_COLUMNS 10
+#define ALIEN_ROWS 3
+
+struct Alien {
+  AlienTypeEnum type;
+  int index;
+};
+
+struct Projectile {
+  bool down;
+};
+
+// Barriers keep their own copy of the sprite mask so every hit can carve
+// a hole in it
+struct Barrier {
+  uint64_t bits[BARRIER_WORDS];
+  // row * BARRIER_COLUMNS + column in the grid init_stage() lays out, kept
+  // when neighbours are destroyed
+  int slot;
+};
+
+struct Ship {};
+
+using AlienArchetype = Archetype<Position, Sprite, Alien>;
+using ProjectileArchetype =
+    Archetype<Position, PrevPosition, Velocity, Sprite, Projectile>;
+using BarrierArchetype = Archetype<Position, Barrier>;
+using ShipArchetype = Archetype<Position, PrevPosition, Sprite, Ship>;
+
+using GameWorld = World<AlienArchetype, ProjectileArchetype, BarrierArchetype,
+                        ShipArchetype>;
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Handle to one row of one archetype. Rows only move in World::flush(), so
+// a handle stays valid until the next flush.
+struct Entity {
+  uint32_t archetype;
+  uint32_t index;
+};
+
+// Entities made of exactly the listed components. Every component has its
+// own dense column and row i of each column belongs to the same entity.
+template <typename... Components> class Archetype {
+public:
+  template <typename C>
+  static constexpr bool has = (std::is_same_v<C, Components> || ...);
+
+  size_t size() const { return destroyed.size(); }
+
+  template <typename C> std::vector<C> &column() {
+    return std::get<std::vector<C>>(columns);
+  }
+
+  bool alive(size_t index) const { return !destroyed[index]; }
+
+  size_t push(Components... components) {
+    (column<Components>().push_back(components), ...);
+    destroyed.push_back(false);
+    return size() - 1;
+  }
+
+  void mark_destroyed(size_t index) { destroyed[index] = true; }
+
+  // Slides every live row down over the destroyed ones in a single pass,
+  // keeping their order
+  void compact() {
+    size_t live = 0;
+    for (size_t i = 0; i < size(); i++) {
+      if (destroyed[i]) {
+        continue;
+      }
+      if (live != i) {
+        ((column<Components>()[live] = column<Components>()[i]), ...);
+      }
+      live++;
+    }
+
+    (column<Components>().erase(column<Components>().begin() + live,
+                                column<Components>().end()),
+     ...);
+    destroyed.assign(live, false);
+  }
+
+  void reserve(size_t capacity) {
+    (column<Components>().reserve(capacity), ...);
+    destroyed.reserve(capacity);
+  }
+
+  size_t capacity() { return destroyed.capacity(); }
+
+  void clear() {
+    (column<Components>().clear(), ...);
+    destroyed.clear();
+  }
+
+private:
+  std::tuple<std::vector<Components>...> columns;
+  std::vector<uint8_t> destroyed;
+};
+
+// A fixed set of archetypes. Systems iterate with each<Components...>(),
+// which visits every live row of every archetype that has all of them.
+// Destruction is deferred: destroy() hides the row from queries right away
+// and records it in a command buffer, and flush() compacts each archetype
+// named in the buffer once, so systems can destroy while iterating and a
+// frame's removals cost O(n) in total instead of O(n) each.
+//
+// Spawning into an archetype while iterating that same archetype is not
+// allowed, the columns may reallocate under the loop.
+template <typename... Archetypes> class World {
+  static_assert(sizeof...(Archetypes) <= 32,
+                "flush() tracks dirty archetypes in a bitmask");
+
+public:
+  template <typename A> A &archetype() { return std::get<A>(archetypes); }
+
+  // Handle to row index of archetype A
+  template <typename A> Entity entity(uint32_t index) {
+    return {id_of<A>(), index};
+  }
+
+  template <typename A, typename... Components>
+  Entity spawn(Components... components) {
+    return {id_of<A>(), (uint32_t)archetype<A>().push(components...)};
+  }
+
+  template <typename C> C *get(Entity entity) {
+    C *component = nullptr;
+    for_each_archetype([&](auto &archetype, uint32_t id) {
+      if constexpr (std::decay_t<decltype(archetype)>::template has<C>) {
+        if (id == entity.archetype) {
+          component = &archetype.template column<C>()[entity.index];
+        }
+      }
+    });
+    return component;
+  }
+
+  bool alive(Entity entity) {
+    bool alive = false;
+    for_each_archetype([&](auto &archetype, uint32_t id) {
+      if (id == entity.archetype) {
+        alive = archetype.alive(entity.index);
+      }
+    });
+    return alive;
+  }
+
+  template <typename... Components, typename F> void each(F fn) {
+    for_each_archetype([&](auto &archetype, uint32_t id) {
+      using A = std::decay_t<decltype(archetype)>;
+      if constexpr ((A::template has<Components> && ...)) {
+        auto columns =
+            std::make_tuple(archetype.template column<Components>().data()...);
+        size_t size = archetype.size();
+
+        for (size_t i = 0; i < size; i++) {
+          if (archetype.alive(i)) {
+            fn(Entity{id, (uint32_t)i},
+               std::get<Components *>(columns)[i]...);
+          }
+        }
+      }
+    });
+  }
+
+  void destroy(Entity entity) {
+    for_each_archetype([&](auto &archetype, uint32_t id) {
+      if (id == entity.archetype && archetype.alive(entity.index)) {
+        archetype.mark_destroyed(entity.index);
+        pending.push_back(entity);
+      }
+    });
+  }
+
+  void flush() {
+    uint32_t dirty = 0;
+    for (Entity entity : pending) {
+      dirty |= 1u << entity.archetype;
+    }
+
+    for_each_archetype([&](auto &archetype, uint32_t id) {
+      if (dirty & (1u << id)) {
+        archetype.compact();
+      }
+    });
+    pending.clear();
+  }
+
+  // Room for capacity rows of A, and for destroying every reserved row in
+  // one frame, without allocating
+  template <typename A> void reserve(size_t capacity) {
+    archetype<A>().reserve(capacity);
+
+    size_t total = 0;
+    for_each_archetype(
+        [&](auto &archetype, uint32_t) { total += archetype.capacity(); });
+    pending.reserve(total);
+  }
+
+  // Empties one archetype and keeps its memory. Only valid between a
+  // flush() and the next destroy().
+  template <typename A> void clear() { archetype<A>().clear(); }
+
+  void clear() {
+    for_each_archetype([](auto &archetype, uint32_t) { archetype.clear(); });
+    pending.clear();
+  }
+
+private:
+  template <typename A> static constexpr uint32_t id_of() {
+    uint32_t id = 0;
+    bool found = false;
+    ((found = found || std::is_same_v<A, Archetypes>, id += !found), ...);
+    return id;
+  }
+
+  template <typename F> void for_each_archetype(F fn) {
+    uint32_t id = 0;
+    std::apply([&](auto &...archetype) { (fn(archetype, id++), ...); },
+               archetypes);
+  }
+
+  std::tuple<Archetypes...> archetypes;
+  std::vector<Entity> pending;
+};
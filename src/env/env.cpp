@@ -0,0 +1,164 @@
+#include "env.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <string>
+
+bool env_load_resources(const char *dir) {
+  std::string path = std::string(dir) + "/atlas.bin";
+  if (!load_atlas(path.c_str())) {
+    return false;
+  }
+  build_animations();
+
+  path = std::string(dir) + "/stages.bin";
+  if (!load_stages(path.c_str())) {
+    return false;
+  }
+  return true;
+}
+
+void Env::reset(uint64_t seed) {
+  game_reset(&game, seed);
+}
+
+StepResult Env::step(int action) {
+  game.input = (action & ACTION_LEFT ? INPUT_LEFT : 0) |
+               (action & ACTION_RIGHT ? INPUT_RIGHT : 0) |
+               (action & ACTION_SHOOT ? INPUT_SHOOT : 0);
+
+  int score = game.score;
+  tick(&game);
+
+  return {float(game.score - score), game.game_over};
+}
+
+static int barrier_pixels(const Barrier &barrier) {
+  int pixels = 0;
+  for (int i = 0; i < BARRIER_WORDS; i++) {
+    pixels += std::popcount(barrier.bits[i]);
+  }
+  return pixels;
+}
+
+void Env::observe(float *observation) {
+  for (int i = 0; i < OBS_SIZE; i++) {
+    observation[i] = 0;
+  }
+
+  GameWorld &world = game.world;
+
+  observation[OBS_SHIP] = world.get<Position>(game.ship)->x / SCREEN_WIDTH;
+  observation[OBS_SHIP + 1] = float(game.lives) / START_LIVES;
+
+  world.each<Position, Alien>([&](Entity, Position &pos, Alien &alien) {
+    float *slot = observation + OBS_ALIENS + alien.index * 3;
+    slot[0] = 1;
+    slot[1] = pos.x / SCREEN_WIDTH;
+    slot[2] = pos.y / SCREEN_HEIGHT;
+  });
+
+  int projectiles = 0;
+  world.each<Position, Projectile>(
+      [&](Entity, Position &pos, Projectile &shot) {
+        if (projectiles == OBS_PROJECTILES) {
+          return;
+        }
+        float *slot = observation + OBS_PROJECTILE_BASE + projectiles * 4;
+        slot[0] = 1;
+        slot[1] = pos.x / SCREEN_WIDTH;
+        slot[2] = pos.y / SCREEN_HEIGHT;
+        slot[3] = shot.down;
+        projectiles++;
+      });
+
+  // Each barrier keeps its grid slot, so the observation stays in place
+  // after some have been removed
+  static const int full = barrier_pixels(make_barrier());
+  world.each<Barrier>([&](Entity, Barrier &barrier) {
+    if (barrier.slot < OBS_BARRIERS) {
+      observation[OBS_BARRIER_BASE + barrier.slot] =
+          float(barrier_pixels(barrier)) / full;
+    }
+  });
+}
+
+VecEnv::VecEnv(int num_envs, int num_threads)
+    : envs(num_envs), seeds(num_envs),
+      num_workers(std::max(1, std::min(num_threads, num_envs))),
+      start(num_workers), finish(num_workers) {
+  // The calling thread works the first slice itself
+  for (int i = 1; i < num_workers; i++) {
+    workers.emplace_back(&VecEnv::worker_loop, this, i);
+  }
+}
+
+VecEnv::~VecEnv() {
+  quit.store(true, std::memory_order_relaxed);
+  start.arrive_and_wait();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+void VecEnv::reset(uint64_t seed, float *observations) {
+  for (int i = 0; i < size(); i++) {
+    seeds[i] = seed + i;
+  }
+  resetting = true;
+  this->observations = observations;
+  dispatch();
+}
+
+void VecEnv::step(const int *actions, float *observations, float *rewards,
+                  uint8_t *dones) {
+  resetting = false;
+  this->actions = actions;
+  this->observations = observations;
+  this->rewards = rewards;
+  this->dones = dones;
+  dispatch();
+}
+
+void VecEnv::dispatch() {
+  start.arrive_and_wait();
+  run_slice(0);
+  finish.arrive_and_wait();
+}
+
+void VecEnv::worker_loop(int worker) {
+  while (true) {
+    start.arrive_and_wait();
+    if (quit.load(std::memory_order_relaxed)) {
+      return;
+    }
+    run_slice(worker);
+    finish.arrive_and_wait();
+  }
+}
+
+void VecEnv::run_slice(int worker) {
+  int begin = size() * worker / num_workers;
+  int end = size() * (worker + 1) / num_workers;
+
+  for (int i = begin; i < end; i++) {
+    Env *env = &envs[i];
+    float *observation = observations + i * OBS_SIZE;
+
+    if (resetting) {
+      env->reset(seeds[i]);
+      env->observe(observation);
+      continue;
+    }
+
+    StepResult result = env->step(actions[i]);
+    if (result.done) {
+      // Seeds stride by the env count so no two episodes share one
+      seeds[i] += size();
+      env->reset(seeds[i]);
+    }
+    rewards[i] = result.reward;
+    dones[i] = result.done;
+    env->observe(observation);
+  }
+}
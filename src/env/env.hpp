@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <barrier>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../game.hpp"
+
+// Action bits, any combination is a valid action
+#define ACTION_LEFT 1
+#define ACTION_RIGHT 2
+#define ACTION_SHOOT 4
+#define NUM_ACTIONS 8
+
+// Entity feature observation, every value scaled to roughly [0, 1]:
+//   ship x, lives
+//   per alien slot (by Alien::index): alive, x, y
+//   per projectile slot: present, x, y, down
+//   per barrier slot: fraction of the barrier left standing
+#define OBS_PROJECTILES 16
+#define OBS_BARRIERS 16
+#define OBS_SHIP 0
+#define OBS_ALIENS 2
+#define OBS_PROJECTILE_BASE (OBS_ALIENS + ALIEN_ROWS * ALIEN_COLUMNS * 3)
+#define OBS_BARRIER_BASE (OBS_PROJECTILE_BASE + OBS_PROJECTILES * 4)
+#define OBS_SIZE (OBS_BARRIER_BASE + OBS_BARRIERS)
+
+// Loads atlas.bin and stages.bin from dir and builds the animation tables.
+// Call once before creating any environment.
+bool env_load_resources(const char *dir);
+
+struct StepResult {
+  // Points scored this step
+  float reward;
+  // Game over. Cleared waves roll on to the next stage.
+  bool done;
+};
+
+// One headless game advanced one tick per step
+class alignas(64) Env {
+public:
+  void reset(uint64_t seed);
+  StepResult step(int action);
+  void observe(float *observation);
+
+  const GameState &state() const { return game; }
+
+private:
+  GameState game;
+};
+
+// N environments stepped in lockstep by a fixed pool of threads. Each
+// worker owns a contiguous slice of the environments and writes straight
+// into the caller's buffers, so observations for env i live at
+// observations + i * OBS_SIZE. A finished environment is reset right away
+// with its next seed and reports the first observation of the new game.
+class VecEnv {
+public:
+  VecEnv(int num_envs, int num_threads);
+  ~VecEnv();
+
+  VecEnv(const VecEnv &) = delete;
+  VecEnv &operator=(const VecEnv &) = delete;
+
+  int size() const { return envs.size(); }
+
+  void reset(uint64_t seed, float *observations);
+  void step(const int *actions, float *observations, float *rewards,
+            uint8_t *dones);
+
+private:
+  void run_slice(int worker);
+  void worker_loop(int worker);
+  void dispatch();
+
+  std::vector<Env> envs;
+  std::vector<uint64_t> seeds;
+  std::vector<std::thread> workers;
+  int num_workers;
+  std::barrier<> start;
+  std::barrier<> finish;
+  std::atomic<bool> quit{false};
+
+  // Current job, written before start and read by every worker
+  bool resetting;
+  const int *actions;
+  float *observations;
+  float *rewards;
+  uint8_t *dones;
+};
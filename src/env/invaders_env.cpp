@@ -0,0 +1,54 @@
+#include "invaders_env.h"
+
+#include "env.hpp"
+
+struct InvadersEnv {
+  Env env;
+};
+
+struct InvadersVecEnv {
+  VecEnv env;
+};
+
+int invaders_load_resources(const char *resources_dir) {
+  return env_load_resources(resources_dir) ? 0 : -1;
+}
+
+int invaders_observation_size(void) { return OBS_SIZE; }
+
+InvadersEnv *invaders_env_create(void) { return new InvadersEnv; }
+
+void invaders_env_destroy(InvadersEnv *env) { delete env; }
+
+void invaders_env_reset(InvadersEnv *env, uint64_t seed, float *observation) {
+  env->env.reset(seed);
+  env->env.observe(observation);
+}
+
+float invaders_env_step(InvadersEnv *env, int action, float *observation,
+                        int *done) {
+  StepResult result = env->env.step(action);
+  env->env.observe(observation);
+  *done = result.done;
+  return result.reward;
+}
+
+InvadersVecEnv *invaders_vec_env_create(int num_envs, int num_threads) {
+  if (num_envs <= 0) {
+    return NULL;
+  }
+  return new InvadersVecEnv{VecEnv(num_envs, num_threads)};
+}
+
+void invaders_vec_env_destroy(InvadersVecEnv *env) { delete env; }
+
+void invaders_vec_env_reset(InvadersVecEnv *env, uint64_t seed,
+                            float *observations) {
+  env->env.reset(seed, observations);
+}
+
+void invaders_vec_env_step(InvadersVecEnv *env, const int *actions,
+                           float *observations, float *rewards,
+                           uint8_t *dones) {
+  env->env.step(actions, observations, rewards, dones);
+}
@@ -0,0 +1,46 @@
+/* C interface to the headless game for training agents. Observations are
+ * INVADERS_OBS_SIZE floats per environment, laid out as described in
+ * env.hpp. Actions are a bitwise OR of the INVADERS_ACTION_* flags. */
+#ifndef INVADERS_ENV_H
+#define INVADERS_ENV_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INVADERS_ACTION_LEFT 1
+#define INVADERS_ACTION_RIGHT 2
+#define INVADERS_ACTION_SHOOT 4
+
+typedef struct InvadersEnv InvadersEnv;
+typedef struct InvadersVecEnv InvadersVecEnv;
+
+/* Loads the sprite data from the Resources directory, returns 0 on success */
+int invaders_load_resources(const char *resources_dir);
+
+int invaders_observation_size(void);
+
+InvadersEnv *invaders_env_create(void);
+void invaders_env_destroy(InvadersEnv *env);
+void invaders_env_reset(InvadersEnv *env, uint64_t seed, float *observation);
+/* Returns the reward, *done is set to 1 when the episode ended */
+float invaders_env_step(InvadersEnv *env, int action, float *observation,
+                        int *done);
+
+/* num_envs games stepped together on num_threads threads. Buffers hold one
+ * entry (or INVADERS_OBS_SIZE floats) per environment, back to back. */
+InvadersVecEnv *invaders_vec_env_create(int num_envs, int num_threads);
+void invaders_vec_env_destroy(InvadersVecEnv *env);
+void invaders_vec_env_reset(InvadersVecEnv *env, uint64_t seed,
+                            float *observations);
+void invaders_vec_env_step(InvadersVecEnv *env, const int *actions,
+                           float *observations, float *rewards,
+                           uint8_t *dones);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+#include "fire.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+void fire_scheduler_init(FireScheduler *fire, uint64_t tick, int mean_ticks,
+                         Rng *rng) {
+  for (int i = 0; i < ALIEN_COLUMNS; i++) {
+    fire->rows[i] = 0;
+    fire->columns[i] = i;
+  }
+
+  // Fisher-Yates over the columns
+  for (int i = ALIEN_COLUMNS - 1; i > 0; i--) {
+    int j = rng_next(rng) % (i + 1);
+    uint8_t column = fire->columns[i];
+    fire->columns[i] = fire->columns[j];
+    fire->columns[j] = column;
+  }
+
+  // Exponentially distributed gaps on top of a reload time
+  int spread = std::max(mean_ticks - FIRE_MIN_TICKS, 0);
+  for (int i = 0; i < FIRE_INTERVALS; i++) {
+    double u = rng_uniform(rng);
+    fire->intervals[i] =
+        FIRE_MIN_TICKS +
+        (uint16_t)(-std::log(u) * spread);
+  }
+
+  fire->next_interval = 0;
+  fire->next_column = 0;
+  fire->next_tick = tick + fire->intervals[0];
+  fire->aimed = false;
+}
+
+void fire_scheduler_add(FireScheduler *fire, int alien_index) {
+  fire->rows[alien_index % ALIEN_COLUMNS] |= 1u
+                                             << (alien_index / ALIEN_COLUMNS);
+}
+
+void fire_scheduler_kill(FireScheduler *fire, int alien_index) {
+  fire->rows[alien_index % ALIEN_COLUMNS] &=
+      ~(1u << (alien_index / ALIEN_COLUMNS));
+}
+
+int fire_scheduler_front(const FireScheduler *fire, int column) {
+  uint32_t rows = fire->rows[column];
+  if (rows == 0) {
+    return -1;
+  }
+  return std::countr_zero(rows) * ALIEN_COLUMNS + column;
+}
+
+bool fire_scheduler_due(FireScheduler *fire, uint64_t tick) {
+  if (tick < fire->next_tick) {
+    return false;
+  }
+
+  fire->next_interval = (fire->next_interval + 1) % FIRE_INTERVALS;
+  fire->next_tick = tick + fire->intervals[fire->next_interval];
+  // Alternate between shots aimed at the ship and shots from the table
+  fire->aimed = !fire->aimed;
+  return true;
+}
+
+int fire_scheduler_column(FireScheduler *fire) {
+  for (int i = 0; i < ALIEN_COLUMNS; i++) {
+    int column = fire->columns[fire->next_column];
+    fire->next_column = (fire->next_column + 1) % ALIEN_COLUMNS;
+    if (fire->rows[column] != 0) {
+      return column;
+    }
+  }
+  return -1;
+}
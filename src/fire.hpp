@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+#include "components.hpp"
+#include "rng.hpp"
+
+#define FIRE_INTERVALS 64
+#define FIRE_MIN_TICKS 8
+
+// Decides when the formation shoots and which alien pulls the trigger.
+// Only the front-most alien of a column may fire, like the arcade game, so
+// each column keeps a bitmask of its live rows and the front is the lowest
+// set bit. Shot spacing comes from a table of intervals drawn once up
+// front, so a tick without a shot costs one comparison.
+struct FireScheduler {
+  uint32_t rows[ALIEN_COLUMNS];
+  uint8_t columns[ALIEN_COLUMNS];
+  uint16_t intervals[FIRE_INTERVALS];
+  int next_interval;
+  int next_column;
+  uint64_t next_tick;
+  bool aimed;
+};
+
+// Shots come on average mean_ticks apart, and never closer than
+// FIRE_MIN_TICKS
+void fire_scheduler_init(FireScheduler *fire, uint64_t tick, int mean_ticks,
+                         Rng *rng);
+
+void fire_scheduler_add(FireScheduler *fire, int alien_index);
+
+void fire_scheduler_kill(FireScheduler *fire, int alien_index);
+
+// Alien index at the front of column, or -1 once the column is empty
+int fire_scheduler_front(const FireScheduler *fire, int column);
+
+// True when a shot is due this tick. The caller picks the shooter with
+// fire_scheduler_column() or aims on its own if fire->aimed is set.
+bool fire_scheduler_due(FireScheduler *fire, uint64_t tick);
+
+// Next non-empty column from the shuffled column table, or -1
+int fire_scheduler_column(FireScheduler *fire);
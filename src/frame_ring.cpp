@@ -0,0 +1,93 @@
+#include "frame_ring.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Frames start on a page boundary after the header
+#define FRAME_RING_FRAME_OFFSET 4096
+
+static_assert(sizeof(FrameRingHeader) <= FRAME_RING_FRAME_OFFSET,
+              "frame ring header does not fit before the frames");
+
+bool frame_ring_open(FrameRing *ring, const char *name) {
+  size_t size = FRAME_RING_FRAME_OFFSET +
+                size_t(FRAME_RING_SLOTS) * FRAME_PIXELS * sizeof(uint32_t);
+
+  shm_unlink(name);
+  int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    std::cout << "Failed to create shared memory " << name << ": "
+              << strerror(errno) << std::endl;
+    return false;
+  }
+
+  if (ftruncate(fd, size) != 0) {
+    std::cout << "Failed to size shared memory " << name << ": "
+              << strerror(errno) << std::endl;
+    close(fd);
+    shm_unlink(name);
+    return false;
+  }
+
+  void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    std::cout << "Failed to map shared memory " << name << ": "
+              << strerror(errno) << std::endl;
+    shm_unlink(name);
+    return false;
+  }
+
+  FrameRingHeader *header = new (memory) FrameRingHeader;
+  header->frames.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < FRAME_RING_SLOTS; i++) {
+    header->sequence[i].store(0, std::memory_order_relaxed);
+  }
+  header->version = FRAME_RING_VERSION;
+  header->width = SCREEN_WIDTH;
+  header->height = SCREEN_HEIGHT;
+  header->slots = FRAME_RING_SLOTS;
+  header->frame_offset = FRAME_RING_FRAME_OFFSET;
+  // Magic last, a reader that sees it sees a complete header
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(header->magic, FRAME_RING_MAGIC, 4);
+
+  ring->header = header;
+  ring->frames = (uint32_t *)((char *)memory + FRAME_RING_FRAME_OFFSET);
+  ring->size = size;
+  strncpy(ring->name, name, sizeof(ring->name) - 1);
+  ring->name[sizeof(ring->name) - 1] = 0;
+  return true;
+}
+
+void frame_ring_close(FrameRing *ring) {
+  if (!ring->header) {
+    return;
+  }
+  munmap(ring->header, ring->size);
+  shm_unlink(ring->name);
+  ring->header = NULL;
+  ring->frames = NULL;
+}
+
+uint32_t *frame_ring_begin(FrameRing *ring) {
+  uint64_t frame = ring->header->frames.load(std::memory_order_relaxed);
+  ring->header->sequence[frame % FRAME_RING_SLOTS].store(
+      2 * frame + 1, std::memory_order_relaxed);
+  // Readers must not see pixel writes before the slot is marked odd
+  std::atomic_thread_fence(std::memory_order_release);
+  return frame_ring_slot(ring, frame);
+}
+
+void frame_ring_publish(FrameRing *ring) {
+  uint64_t frame = ring->header->frames.load(std::memory_order_relaxed);
+  ring->header->sequence[frame % FRAME_RING_SLOTS].store(
+      2 * (frame + 1), std::memory_order_release);
+  ring->header->frames.store(frame + 1, std::memory_order_release);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "raster.hpp"
+
+#define FRAME_RING_MAGIC "SIFR"
+#define FRAME_RING_VERSION 1
+#define FRAME_RING_SLOTS 8
+
+// Layout of the shared memory segment. The header is followed by
+// FRAME_RING_SLOTS frames of FRAME_PIXELS RGBA pixels each (see
+// raster_frame). Frame n goes to slot n % FRAME_RING_SLOTS.
+//
+// Each slot has a sequence counter used as a seqlock: it is odd while the
+// game writes the slot and 2 * (n + 1) once frame n is complete. A reader
+// loads the counter, reads the pixels in place and loads the counter
+// again; if both loads agree and are even the frame was not torn. The game
+// never waits for readers, a slow reader just sees a newer frame or
+// retries.
+struct FrameRingHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t slots;
+  uint32_t frame_offset;
+  // Frames published so far
+  alignas(64) std::atomic<uint64_t> frames;
+  alignas(64) std::atomic<uint64_t> sequence[FRAME_RING_SLOTS];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "frame ring counters must be lock free to be shared");
+
+struct FrameRing {
+  FrameRingHeader *header;
+  uint32_t *frames;
+  size_t size;
+  char name[64];
+};
+
+inline uint32_t *frame_ring_slot(FrameRing *ring, uint64_t frame) {
+  return ring->frames + (frame % FRAME_RING_SLOTS) * FRAME_PIXELS;
+}
+
+// Creates (or replaces) the POSIX shared memory object name, e.g.
+// "/invaders-frames", and maps it. Returns false on failure.
+bool frame_ring_open(FrameRing *ring, const char *name);
+
+// Unmaps and unlinks the segment
+void frame_ring_close(FrameRing *ring);
+
+// Slot the next frame should be rendered into, marked as being written
+uint32_t *frame_ring_begin(FrameRing *ring);
+
+// Publishes the frame started by frame_ring_begin
+void frame_ring_publish(FrameRing *ring);
+
+// Reader side: sequence to check a slot against after reading it, or 0
+// when frame is not (or no longer) in the ring
+inline uint64_t frame_ring_read_begin(const FrameRingHeader *header,
+                                      uint64_t frame) {
+  uint64_t sequence = header->sequence[frame % FRAME_RING_SLOTS].load(
+      std::memory_order_acquire);
+  return sequence == 2 * (frame + 1) ? sequence : 0;
+}
+
+// True when the slot was not overwritten while it was being read
+inline bool frame_ring_read_end(const FrameRingHeader *header, uint64_t frame,
+                                uint64_t sequence) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return header->sequence[frame % FRAME_RING_SLOTS].load(
+             std::memory_order_relaxed) == sequence;
+}
@@ -0,0 +1,548 @@
+#include "game.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Points per alien type, indexed by AlienTypeEnum
+static const int alien_points[] = {30, 20, 20, 10};
+
+bool box_collide(Box2f a, Box2f b) {
+  if (((a.min.x >= b.max.x) || (a.max.x <= b.min.x)) ||
+      ((a.min.y >= b.max.y) || (a.max.y <= b.min.y))) {
+    return false;
+  }
+  return true;
+}
+
+const AtlasFrame *atlas_frame(int frame) { return &atlas.frames[frame]; }
+
+// Atlas frame n of a sprite's animation, wrapping around
+int sprite_frame(SpriteId id, int n) {
+  const AtlasSprite *sprite = &atlas.sprites[id];
+  return sprite->first_frame + n % sprite->frame_count;
+}
+
+Box2f sprite_box(int frame, Vector2f pos) {
+  const AtlasFrame *f = atlas_frame(frame);
+  Box2f box = {Vector2f({pos.x + f->offset_x, pos.y + f->offset_y}),
+               Vector2f({pos.x + f->offset_x + f->w,
+                         pos.y + f->offset_y + f->h})};
+  return box;
+}
+
+// Bounding box test first, then AND the overlapping mask rows
+bool sprite_collide(int a_frame, Vector2f a_pos, int b_frame, Vector2f b_pos) {
+  if (!box_collide(sprite_box(a_frame, a_pos), sprite_box(b_frame, b_pos))) {
+    return false;
+  }
+
+  const AtlasFrame *a = atlas_frame(a_frame);
+  const AtlasFrame *b = atlas_frame(b_frame);
+  int dx = int(b_pos.x) - int(a_pos.x);
+  int dy = int(b_pos.y) - int(a_pos.y);
+
+  for (int y = std::max(0, dy); y < std::min(SPRITE_SIZE, SPRITE_SIZE + dy);
+       y++) {
+    uint32_t row_a = a->mask[y];
+    uint32_t row_b = b->mask[y - dy];
+    if (dx >= 0 ? (row_a & (row_b << dx)) : ((row_a << -dx) & row_b)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Packs a sprite mask into 64-bit words of four 16-pixel rows each, moved
+// by (dx, dy) inside a 16x16 frame. Pixels pushed off the frame are dropped.
+void mask_words(const AtlasFrame *frame, int dx, int dy, uint64_t *words) {
+  for (int i = 0; i < BARRIER_WORDS; i++) {
+    words[i] = 0;
+  }
+
+  if (abs(dx) >= SPRITE_SIZE || abs(dy) >= SPRITE_SIZE) {
+    return;
+  }
+
+  for (int y = std::max(0, dy); y < std::min(SPRITE_SIZE, SPRITE_SIZE + dy);
+       y++) {
+    uint32_t row = frame->mask[y - dy];
+    row = dx >= 0 ? row << dx : row >> -dx;
+    words[y / ROWS_PER_WORD] |= uint64_t(row & 0xFFFF)
+                                << (y % ROWS_PER_WORD * SPRITE_SIZE);
+  }
+}
+
+int current_frame(GameState *state, Sprite sprite) {
+  return animation_frame(sprite.id, state->time.ticks);
+}
+
+int barrier_sprite() { return sprite_frame(SPRITE_BARRIER, 0); }
+
+// Explosion frame reused as the crater a shot leaves in a barrier
+int blast_sprite() { return sprite_frame(SPRITE_EXPLOSION, 1); }
+
+Barrier make_barrier() {
+  Barrier barrier = {};
+  mask_words(atlas_frame(barrier_sprite()), 0, 0, barrier.bits);
+  return barrier;
+}
+
+bool barrier_collide(Barrier *barrier, Vector2f barrier_pos, int frame,
+                     Vector2f pos) {
+  uint64_t words[BARRIER_WORDS];
+  mask_words(atlas_frame(frame), int(pos.x) - int(barrier_pos.x),
+             int(pos.y) - int(barrier_pos.y), words);
+
+  uint64_t hit = 0;
+  for (int i = 0; i < BARRIER_WORDS; i++) {
+    hit |= words[i] & barrier->bits[i];
+  }
+  return hit != 0;
+}
+
+// Clears the blast mask centered on center from the barrier
+void barrier_erode(Barrier *barrier, Vector2f barrier_pos, Vector2f center) {
+  const AtlasFrame *blast = atlas_frame(blast_sprite());
+  uint64_t words[BARRIER_WORDS];
+  mask_words(blast,
+             int(center.x) - blast->offset_x - blast->w / 2 -
+                 int(barrier_pos.x),
+             int(center.y) - blast->offset_y - blast->h / 2 -
+                 int(barrier_pos.y),
+             words);
+
+  for (int i = 0; i < BARRIER_WORDS; i++) {
+    barrier->bits[i] &= ~words[i];
+  }
+}
+
+bool barrier_destroyed(Barrier *barrier) {
+  uint64_t bits = 0;
+  for (int i = 0; i < BARRIER_WORDS; i++) {
+    bits |= barrier->bits[i];
+  }
+  return bits == 0;
+}
+
+void spawn_projectile(GameState *state, Vector2f pos, bool down) {
+  state->world.spawn<ProjectileArchetype>(
+      Position{pos}, PrevPosition{pos},
+      Velocity{{0, down ? -PROJECTILE_SPEED : PROJECTILE_SPEED}},
+      Sprite{SPRITE_PROJECTILE}, Projectile{down});
+}
+
+void game_reset(GameState *state, uint64_t seed) {
+  state->world.clear();
+  state->explosions = {};
+  state->time = {};
+  state->input = 0;
+  rng_seed(&state->rng, seed);
+
+  // Sized for the largest stage, so later waves never allocate
+  state->world.reserve<AlienArchetype>(stages.header.max_aliens);
+  state->world.reserve<BarrierArchetype>(stages.header.max_barriers);
+  state->world.reserve<ProjectileArchetype>(MAX_PROJECTILES);
+  state->world.reserve<ShipArchetype>(1);
+
+  state->ship = state->world.spawn<ShipArchetype>(
+      Position{{0, 4}}, PrevPosition{{0, 4}}, Sprite{SPRITE_SHIP}, Ship{});
+  state->stage = 0;
+  state->lives = START_LIVES;
+  state->score = 0;
+  state->game_over = false;
+  state->march_beats = 0;
+  state->sounds.count = 0;
+
+  init_stage(state);
+}
+
+void init_stage(GameState *state) {
+  const StageDef *def = stage_def(state->stage);
+
+  state->world.clear<AlienArchetype>();
+  state->world.clear<ProjectileArchetype>();
+  state->world.clear<BarrierArchetype>();
+
+  fire_scheduler_init(&state->fire, state->time.ticks, def->fire_mean_ticks,
+                      &state->rng);
+
+  for (int y = 0; y < ALIEN_ROWS; y++) {
+    for (int x = 0; x < ALIEN_COLUMNS; x++) {
+      uint8_t cell = def->types[y][x];
+      if (cell == STAGE_EMPTY) {
+        continue;
+      }
+
+      AlienTypeEnum type = cell == STAGE_RANDOM
+                               ? AlienTypeEnum(rng_next(&state->rng) % 4)
+                               : AlienTypeEnum(cell);
+      int index = y * ALIEN_COLUMNS + x;
+      state->world.spawn<AlienArchetype>(
+          Position{{(float)(10 + x * 14),
+                    (float)def->bottom_y + y * ROW_HEIGHT}},
+          Sprite{SpriteId(SPRITE_ALIEN_CYAN + int(type))},
+          Alien{type, index});
+      fire_scheduler_add(&state->fire, index);
+    }
+  }
+
+  for (int y = 0; y < def->barrier_rows; y++) {
+    for (int x = 0; x < BARRIER_COLUMNS; x++) {
+      Barrier barrier = make_barrier();
+      barrier.slot = y * BARRIER_COLUMNS + x;
+      state->world.spawn<BarrierArchetype>(
+          Position{{(float)(BARRIER_LEFT + x * BARRIER_PITCH_X),
+                    (float)(BARRIER_BOTTOM + y * BARRIER_PITCH_Y)}},
+          barrier);
+    }
+  }
+
+  state->stage_num_aliens = state->world.archetype<AlienArchetype>().size();
+  // game_reset() reserved room for the counts the packer wrote
+  assert(state->stage_num_aliens == def->alien_count);
+  state->march_speed = def->march_speed;
+  march_reset(&state->march);
+  state->move = Move::RIGHT;
+}
+
+// One march step of a single alien in direction M
+template <Move M> inline void march_step(Position *pos, int speed) {
+  if constexpr (M == Move::RIGHT) {
+    pos->x += speed;
+  } else if constexpr (M == Move::LEFT) {
+    pos->x -= speed;
+  } else {
+    pos->y -= ROW_HEIGHT;
+  }
+}
+
+// Moves the aliens whose turn it is this tick, as handed out by the march
+// cursor
+template <Move M> void march_system(GameState *state, int speed) {
+  AlienArchetype *aliens = &state->world.archetype<AlienArchetype>();
+  int num_aliens = aliens->size();
+  if (num_aliens == 0) {
+    return;
+  }
+
+  int first;
+  int count = march_advance(&state->march, num_aliens, &first);
+  Position *pos = aliens->column<Position>().data();
+  for (int row = first; row < first + count; row++) {
+    march_step<M>(&pos[row], speed);
+  }
+
+  // The first row starts each step of the whole formation
+  if (first == 0 && count > 0) {
+    sound_emit(&state->sounds,
+               SoundId(SOUND_MARCH_1 + state->march_beats++ % 4));
+  }
+}
+
+// True when the next step in direction M would take the formation past
+// the padding. A min or max over the position column, with no per-alien
+// branches. tick() runs after the last flush, so every row is alive.
+template <Move M> bool formation_at_edge(GameState *state, int speed) {
+  if constexpr (M == Move::DOWN) {
+    return false;
+  } else {
+    AlienArchetype *aliens = &state->world.archetype<AlienArchetype>();
+    const Position *pos = aliens->column<Position>().data();
+    int num_aliens = aliens->size();
+
+    if constexpr (M == Move::RIGHT) {
+      // Right edge of each alien sprite relative to its position
+      float extent[SPRITE_COUNT];
+      for (int id = 0; id < SPRITE_COUNT; id++) {
+        const AtlasFrame *f =
+            atlas_frame(animation_frame(SpriteId(id), state->time.ticks));
+        extent[id] = f->offset_x + f->w;
+      }
+
+      const Sprite *sprite = aliens->column<Sprite>().data();
+      float right = -INFINITY;
+      for (int i = 0; i < num_aliens; i++) {
+        right = std::max(right, pos[i].x + extent[sprite[i].id]);
+      }
+      return right + speed >= SCREEN_WIDTH - PADDING;
+    } else {
+      float left = INFINITY;
+      for (int i = 0; i < num_aliens; i++) {
+        left = std::min(left, pos[i].x);
+      }
+      return left - speed <= PADDING;
+    }
+  }
+}
+
+// Aliens are spawned in index order and compaction keeps that order, so
+// the alien column stays sorted by index
+Entity find_alien(GameState *state, int index) {
+  AlienArchetype *aliens = &state->world.archetype<AlienArchetype>();
+  std::vector<Alien> &column = aliens->column<Alien>();
+
+  auto it = std::lower_bound(
+      column.begin(), column.end(), index,
+      [](const Alien &alien, int index) { return alien.index < index; });
+  return state->world.entity<AlienArchetype>(it - column.begin());
+}
+
+void alien_fire_system(GameState *state) {
+  FireScheduler *fire = &state->fire;
+
+  if (!fire_scheduler_due(fire, state->time.ticks)) {
+    return;
+  }
+
+  int shooter = -1;
+  if (fire->aimed) {
+    // Front alien closest to the ship
+    float ship_x = state->world.get<Position>(state->ship)->x;
+    float closest = 0;
+    for (int column = 0; column < ALIEN_COLUMNS; column++) {
+      int front = fire_scheduler_front(fire, column);
+      if (front < 0) {
+        continue;
+      }
+
+      float distance =
+          fabs(state->world.get<Position>(find_alien(state, front))->x -
+               ship_x);
+      if (shooter < 0 || distance < closest) {
+        shooter = front;
+        closest = distance;
+      }
+    }
+  } else {
+    int column = fire_scheduler_column(fire);
+    if (column >= 0) {
+      shooter = fire_scheduler_front(fire, column);
+    }
+  }
+
+  if (shooter < 0) {
+    return;
+  }
+
+  Position *pos = state->world.get<Position>(find_alien(state, shooter));
+  spawn_projectile(state, {pos->x + 2, pos->y - 2}, true);
+}
+
+void movement_system(GameState *state) {
+  state->world.each<Position, Velocity>(
+      [&](Entity entity, Position &pos, Velocity &velocity) {
+        pos.x += velocity.x * TICK_SECONDS;
+        pos.y += velocity.y * TICK_SECONDS;
+
+        // Shots that left the screen can no longer hit anything
+        if (pos.y < -SPRITE_SIZE || pos.y > SCREEN_HEIGHT) {
+          state->world.destroy(entity);
+        }
+      });
+}
+
+// Removes an alien from the world and from the fire and march schedules
+void kill_alien(GameState *state, Entity alien, const Alien &data) {
+  state->world.destroy(alien);
+  fire_scheduler_kill(&state->fire, data.index);
+  march_kill(&state->march, alien.index);
+}
+
+void collision_system(GameState *state) {
+  GameWorld *world = &state->world;
+  Vector2f ship_pos = *world->get<Position>(state->ship);
+  int ship_frame = current_frame(state, *world->get<Sprite>(state->ship));
+
+  world->each<Position, Sprite, Projectile>(
+      [&](Entity projectile, Position &pos, Sprite &sprite, Projectile &) {
+        if (sprite_collide(ship_frame, ship_pos, current_frame(state, sprite),
+                           pos)) {
+          explosions_spawn(&state->explosions, ship_pos.x + 2, ship_pos.y + 2,
+                           state->time.ticks);
+          sound_emit(&state->sounds, SOUND_SHIP_EXPLOSION);
+          state->lives -= 1;
+          world->destroy(projectile);
+
+          if (state->lives <= 0) {
+            state->game_over = true;
+          }
+        }
+      });
+
+  // Collision projectiles & aliens
+  world->each<Position, Sprite, Alien>([&](Entity alien, Position &alien_pos,
+                                           Sprite &alien_sprite,
+                                           Alien &alien_data) {
+    int alien_frame = current_frame(state, alien_sprite);
+
+    world->each<Position, Sprite, Projectile>(
+        [&](Entity projectile, Position &pos, Sprite &sprite,
+            Projectile &shot) {
+          if (!shot.down && world->alive(alien) &&
+              sprite_collide(alien_frame, alien_pos,
+                             current_frame(state, sprite), pos)) {
+            explosions_spawn(&state->explosions, alien_pos.x + 2,
+                             alien_pos.y + 2, state->time.ticks);
+            world->destroy(projectile);
+            kill_alien(state, alien, alien_data);
+            state->score += alien_points[alien_data.type];
+            sound_emit(&state->sounds, SOUND_ALIEN_EXPLOSION);
+          }
+        });
+
+    if (world->alive(alien) &&
+        sprite_collide(alien_frame, alien_pos, ship_frame, ship_pos)) {
+      kill_alien(state, alien, alien_data);
+      explosions_spawn(&state->explosions, alien_pos.x + 2, alien_pos.y + 2,
+                       state->time.ticks);
+      explosions_spawn(&state->explosions, ship_pos.x + 2, ship_pos.y + 2,
+                       state->time.ticks);
+      sound_emit(&state->sounds, SOUND_SHIP_EXPLOSION);
+      state->lives -= 1;
+
+      if (state->lives <= 0) {
+        state->game_over = true;
+      }
+    }
+  });
+
+  // Shots from both sides carve into barriers at their leading tip
+  world->each<Position, Sprite, Projectile>([&](Entity projectile,
+                                                Position &pos, Sprite &sprite,
+                                                Projectile &shot) {
+    int frame = current_frame(state, sprite);
+    const AtlasFrame *mask = atlas_frame(frame);
+
+    world->each<Position, Barrier>(
+        [&](Entity, Position &barrier_pos, Barrier &barrier) {
+          if (!world->alive(projectile) ||
+              !barrier_collide(&barrier, barrier_pos, frame, pos)) {
+            return;
+          }
+
+          Vector2f tip = {pos.x + mask->offset_x + mask->w / 2,
+                          pos.y + mask->offset_y + (shot.down ? 0 : mask->h)};
+          barrier_erode(&barrier, barrier_pos, tip);
+          world->destroy(projectile);
+        });
+  });
+
+  // Remove barriers
+  world->each<Barrier>([&](Entity entity, Barrier &barrier) {
+    if (barrier_destroyed(&barrier)) {
+      world->destroy(entity);
+    }
+  });
+}
+
+// Player input, movement and collisions, after the aliens had their turn
+static void play_system(GameState *state) {
+  Position *ship_pos = state->world.get<Position>(state->ship);
+
+  if (state->input & INPUT_LEFT) {
+    ship_pos->x -= SHIP_SPEED * TICK_SECONDS;
+  }
+
+  if (state->input & INPUT_RIGHT) {
+    ship_pos->x += SHIP_SPEED * TICK_SECONDS;
+  }
+
+  // Holding shoot fires every tick, a press fires on the tick after it
+  if (state->input & (INPUT_SHOOT | INPUT_PRESSED(INPUT_SHOOT))) {
+    spawn_projectile(state, {ship_pos->x + 4, ship_pos->y + 11}, false);
+    sound_emit(&state->sounds, SOUND_SHOOT);
+  }
+
+  movement_system(state);
+  collision_system(state);
+
+  state->world.flush();
+
+  // Wave cleared, the next one starts in place
+  if (state->world.archetype<AlienArchetype>().size() == 0) {
+    state->stage++;
+    init_stage(state);
+  }
+}
+
+// Turns the formation around or sends it down once every alien took the
+// current step. Runs before the march of the next tick rather than after
+// it, since the last aliens of a step may also be killed in play_system.
+static void march_turn(GameState *state) {
+  if (march_step_done(&state->march,
+                      state->world.archetype<AlienArchetype>().size())) {
+    if (state->move == Move::DOWN) {
+      switch (state->last_shuffle) {
+      case Move::LEFT:
+        state->move = Move::RIGHT;
+        break;
+      case Move::RIGHT:
+        state->move = Move::LEFT;
+        break;
+      case Move::DOWN:
+        assert(false);
+        break;
+      default:
+        break;
+      }
+    }
+
+    bool oob = false;
+    switch (state->move) {
+    case Move::RIGHT:
+      oob = formation_at_edge<Move::RIGHT>(state, state->march_speed);
+      break;
+    case Move::LEFT:
+      oob = formation_at_edge<Move::LEFT>(state, state->march_speed);
+      break;
+    case Move::DOWN:
+      oob = formation_at_edge<Move::DOWN>(state, state->march_speed);
+      break;
+    }
+
+    if (oob) {
+      state->move = Move::DOWN;
+    }
+  }
+}
+
+void tick(GameState *state) {
+  march_turn(state);
+
+  state->time.ticks += 1;
+
+  // Where render() interpolates from until the next tick
+  state->world.each<Position, PrevPosition>(
+      [](Entity, Position &pos, PrevPosition &prev) {
+        prev.x = pos.x;
+        prev.y = pos.y;
+      });
+
+  explosions_animate(&state->explosions, state->time.ticks);
+
+  int Move_speed = state->march_speed;
+
+  if (state->move == Move::RIGHT || state->move == Move::LEFT) {
+    state->last_shuffle = state->move;
+  }
+
+  // The direction is fixed for the whole tick, so pick the specialized
+  // systems once instead of switching per alien
+  switch (state->move) {
+  case Move::RIGHT:
+    march_system<Move::RIGHT>(state, Move_speed);
+    break;
+  case Move::LEFT:
+    march_system<Move::LEFT>(state, Move_speed);
+    break;
+  case Move::DOWN:
+    march_system<Move::DOWN>(state, Move_speed);
+    break;
+  }
+  alien_fire_system(state);
+
+  play_system(state);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+#include "animation.hpp"
+#include "atlas.hpp"
+#include "components.hpp"
+#include "fire.hpp"
+#include "march.hpp"
+#include "rng.hpp"
+#include "sound.hpp"
+#include "stage.hpp"
+
+#define SHIP_SPEED 40.0f
+#define PROJECTILE_SPEED 100.0f
+
+#define SCREEN_WIDTH 224
+#define SCREEN_HEIGHT 256
+
+#define TICKS_PER_SECOND 60
+#define TICK_SECONDS (1.0 / TICKS_PER_SECOND)
+
+#define ROW_HEIGHT 16
+#define ROW_WIDTH SCREEN_WIDTH - 32
+
+#define PADDING 12
+
+// Bottom left barrier and the distance to the next one in its row and
+// column, BARRIER_COLUMNS wide
+#define BARRIER_LEFT 8
+#define BARRIER_BOTTOM 20
+#define BARRIER_PITCH_X 28
+#define BARRIER_PITCH_Y 12
+
+#define START_LIVES 3
+
+// Buttons in GameState::input. The low bits are held at the time of the
+// sample, the high bits were pressed since the sample before, so a tap
+// shorter than a frame still counts.
+#define INPUT_LEFT 0x01
+#define INPUT_RIGHT 0x02
+#define INPUT_SHOOT 0x04
+#define INPUT_PRESSED(buttons) ((buttons) << 4)
+#define INPUT_BUTTONS (INPUT_LEFT | INPUT_RIGHT | INPUT_SHOOT)
+
+// Shots in flight reserved up front, more only cost an allocation
+#define MAX_PROJECTILES 256
+
+// Everything the simulation needs. Nothing in here touches SDL, so the
+// game can run headless (see src/env) as well as behind the window in
+// main.cpp.
+struct GameState {
+  struct {
+    uint64_t ticks;
+  } time;
+
+  // INPUT_* bits, filled in by the front-end before each tick()
+  uint8_t input;
+
+  Rng rng;
+  GameWorld world;
+  Entity ship;
+  Explosions explosions;
+  FireScheduler fire;
+  MarchCursor march;
+  Move move;
+  Move last_shuffle;
+  // Wave being played, stage_def(stage) is its layout
+  int stage;
+  int march_speed;
+  int stage_num_aliens;
+  int lives;
+  int score;
+  // Formation steps so far, picks the note of the march beat
+  int march_beats;
+  // Sounds for the front-end to play, see sound.hpp
+  SoundEvents sounds;
+  // Set once the last life is lost, the caller decides what comes next
+  bool game_over;
+};
+
+const AtlasFrame *atlas_frame(int frame);
+
+// Atlas frame n of a sprite's animation, wrapping around
+int sprite_frame(SpriteId id, int n);
+
+Box2f sprite_box(int frame, Vector2f pos);
+
+int current_frame(GameState *state, Sprite sprite);
+
+Barrier make_barrier();
+
+// Clears the world and starts a new game from seed. Needs load_stages().
+void game_reset(GameState *state, uint64_t seed);
+
+// Lays out wave state->stage, reusing the memory of the last one
+void init_stage(GameState *state);
+
+// One fixed step of TICK_SECONDS, all of the gameplay: input, movement,
+// formation march, alien fire, collisions and animations
+void tick(GameState *state);
@@ -0,0 +1,363 @@
+#include "input.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "game.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <ctime>
+
+#include <fcntl.h>
+#include <linux/input.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+static uint8_t evdev_key_button(int code) {
+  switch (code) {
+  case KEY_LEFT:
+  case KEY_A:
+  case BTN_DPAD_LEFT:
+    return INPUT_LEFT;
+  case KEY_RIGHT:
+  case KEY_D:
+  case BTN_DPAD_RIGHT:
+    return INPUT_RIGHT;
+  case KEY_SPACE:
+  case BTN_SOUTH:
+  case BTN_EAST:
+  case BTN_TRIGGER:
+  case BTN_THUMB:
+    return INPUT_SHOOT;
+  default:
+    return 0;
+  }
+}
+
+static uint8_t evdev_stick(const EvdevInput *evdev, int value) {
+  return value <= evdev->axis_left    ? INPUT_LEFT
+         : value >= evdev->axis_right ? INPUT_RIGHT
+                                      : 0;
+}
+
+static uint8_t evdev_hat(int value) {
+  return value < 0 ? INPUT_LEFT : value > 0 ? INPUT_RIGHT : 0;
+}
+
+// Reads the whole device state back after the kernel dropped events,
+// which may have included key releases
+static void evdev_resync(EvdevInput *evdev, int keys[3], uint8_t *stick,
+                         uint8_t *hat) {
+  uint8_t bits[KEY_MAX / 8 + 1] = {};
+  keys[0] = keys[1] = keys[2] = 0;
+  if (ioctl(evdev->fd, EVIOCGKEY(sizeof(bits)), bits) >= 0) {
+    for (int code = 0; code <= KEY_MAX; code++) {
+      uint8_t button = evdev_key_button(code);
+      if (button && bits[code / 8] & (1 << code % 8)) {
+        keys[button == INPUT_LEFT ? 0 : button == INPUT_RIGHT ? 1 : 2]++;
+      }
+    }
+  }
+
+  input_absinfo abs = {};
+  *stick = ioctl(evdev->fd, EVIOCGABS(ABS_X), &abs) == 0
+               ? evdev_stick(evdev, abs.value)
+               : 0;
+  *hat = ioctl(evdev->fd, EVIOCGABS(ABS_HAT0X), &abs) == 0
+             ? evdev_hat(abs.value)
+             : 0;
+}
+
+static void evdev_loop(EvdevInput *evdev) {
+  // Keys held per button, since several keys map to each
+  int keys[3] = {};
+  uint8_t stick = 0, hat = 0;
+  uint8_t held = 0;
+  uint64_t first_ns = 0;
+  // Set from SYN_DROPPED until the next report
+  bool dropped = false;
+
+  pollfd fds[2] = {{evdev->fd, POLLIN, 0}, {evdev->wake_fd, POLLIN, 0}};
+  while (true) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[1].revents) {
+      break;
+    }
+    if (fds[0].revents & (POLLERR | POLLHUP)) {
+      std::cout << "Input device disconnected" << std::endl;
+      break;
+    }
+
+    // struct, since input_event() below names the SDL side
+    struct input_event events[64];
+    ssize_t n = read(evdev->fd, events, sizeof(events));
+    if (n <= 0) {
+      continue;
+    }
+
+    for (int i = 0; i < int(n / sizeof(struct input_event)); i++) {
+      const struct input_event &ev = events[i];
+      if (first_ns == 0) {
+        first_ns = uint64_t(ev.input_event_sec) * 1000000000 +
+                   uint64_t(ev.input_event_usec) * 1000;
+      }
+
+      if (ev.type == EV_SYN && ev.code == SYN_DROPPED) {
+        dropped = true;
+      } else if (dropped && !(ev.type == EV_SYN && ev.code == SYN_REPORT)) {
+        // Partial state, the resync below replaces it
+      } else if (ev.type == EV_KEY) {
+        uint8_t button = evdev_key_button(ev.code);
+        // Value 2 is autorepeat
+        if (button && ev.value != 2) {
+          int bit = button == INPUT_LEFT ? 0 : button == INPUT_RIGHT ? 1 : 2;
+          keys[bit] = std::max(0, keys[bit] + (ev.value ? 1 : -1));
+        }
+      } else if (ev.type == EV_ABS && ev.code == ABS_X) {
+        stick = evdev_stick(evdev, ev.value);
+      } else if (ev.type == EV_ABS && ev.code == ABS_HAT0X) {
+        hat = evdev_hat(ev.value);
+      } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
+        if (dropped) {
+          evdev_resync(evdev, keys, &stick, &hat);
+          dropped = false;
+        }
+
+        // A report is one consistent state of the device, publish it
+        uint8_t now = stick | hat | (keys[0] ? INPUT_LEFT : 0) |
+                      (keys[1] ? INPUT_RIGHT : 0) |
+                      (keys[2] ? INPUT_SHOOT : 0);
+        evdev->held.store(now, std::memory_order_relaxed);
+        evdev->pressed.fetch_or(now & ~held, std::memory_order_relaxed);
+        held = now;
+
+        // Released after held and pressed, so a sampler that sees the
+        // timestamp also sees the state it belongs to
+        uint64_t expected = 0;
+        evdev->event_ns.compare_exchange_strong(expected, first_ns,
+                                                std::memory_order_release);
+        evdev->events.fetch_add(1, std::memory_order_relaxed);
+        first_ns = 0;
+      }
+    }
+  }
+
+  // Nothing is held once the device is gone, or the ship would keep
+  // going the way the stick pointed when it was unplugged
+  evdev->held.store(0, std::memory_order_relaxed);
+  evdev->pressed.store(0, std::memory_order_relaxed);
+}
+
+static bool evdev_open(EvdevInput *evdev, const char *path) {
+  evdev->fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (evdev->fd < 0) {
+    std::cout << "Failed to open input device " << path << std::endl;
+    return false;
+  }
+
+  // Timestamps on the steady_clock timeline
+  int clock = CLOCK_MONOTONIC;
+  ioctl(evdev->fd, EVIOCSCLOCKID, &clock);
+
+  // Outer quarters of the stick travel count as a direction
+  input_absinfo abs = {};
+  if (ioctl(evdev->fd, EVIOCGABS(ABS_X), &abs) == 0 &&
+      abs.maximum > abs.minimum) {
+    int center = (abs.minimum + abs.maximum) / 2;
+    int quarter = (abs.maximum - abs.minimum) / 4;
+    evdev->axis_left = center - quarter;
+    evdev->axis_right = center + quarter;
+  } else {
+    evdev->axis_left = -1;
+    evdev->axis_right = 1;
+  }
+
+  evdev->wake_fd = eventfd(0, EFD_CLOEXEC);
+  evdev->thread = std::thread(evdev_loop, evdev);
+  return true;
+}
+
+static void evdev_close(EvdevInput *evdev) {
+  if (evdev->fd < 0) {
+    return;
+  }
+
+  uint64_t one = 1;
+  if (write(evdev->wake_fd, &one, sizeof(one)) == sizeof(one)) {
+    evdev->thread.join();
+  } else {
+    // The thread cannot be woken, leave it blocked rather than hang here
+    std::cout << "Failed to stop the input thread" << std::endl;
+    evdev->thread.detach();
+  }
+  close(evdev->wake_fd);
+  close(evdev->fd);
+  evdev->fd = -1;
+}
+#else
+static bool evdev_open(EvdevInput *, const char *) {
+  std::cout << "evdev input is only available on Linux" << std::endl;
+  return false;
+}
+
+static void evdev_close(EvdevInput *) {}
+#endif
+
+bool input_open(Input *input, const char *evdev_path) {
+  for (SDL_GameController *&controller : input->controllers) {
+    controller = NULL;
+  }
+  input->pressed = 0;
+  input->last_held = 0;
+  input->event_ns = 0;
+
+  bool ok = true;
+  if (SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER)) {
+    std::cout << "Failed to initialize game controllers: " << SDL_GetError()
+              << std::endl;
+    ok = false;
+  }
+
+  if (evdev_path && !evdev_open(&input->evdev, evdev_path)) {
+    ok = false;
+  }
+  return ok;
+}
+
+void input_close(Input *input) {
+  evdev_close(&input->evdev);
+
+  for (SDL_GameController *&controller : input->controllers) {
+    if (controller) {
+      SDL_GameControllerClose(controller);
+      controller = NULL;
+    }
+  }
+}
+
+static uint8_t controller_button(int button) {
+  switch (button) {
+  case SDL_CONTROLLER_BUTTON_DPAD_LEFT:
+    return INPUT_LEFT;
+  case SDL_CONTROLLER_BUTTON_DPAD_RIGHT:
+    return INPUT_RIGHT;
+  case SDL_CONTROLLER_BUTTON_A:
+  case SDL_CONTROLLER_BUTTON_B:
+    return INPUT_SHOOT;
+  default:
+    return 0;
+  }
+}
+
+bool input_event(Input *input, const SDL_Event *event) {
+  switch (event->type) {
+  case SDL_KEYDOWN:
+    switch (event->key.keysym.sym) {
+    case SDLK_a:
+    case SDLK_LEFT:
+      input->pressed |= INPUT_LEFT;
+      return true;
+    case SDLK_d:
+    case SDLK_RIGHT:
+      input->pressed |= INPUT_RIGHT;
+      return true;
+    case SDLK_SPACE:
+      input->pressed |= INPUT_SHOOT;
+      return true;
+    default:
+      return false;
+    }
+
+  case SDL_CONTROLLERBUTTONDOWN:
+    input->pressed |= controller_button(event->cbutton.button);
+    return true;
+
+  case SDL_CONTROLLERDEVICEADDED:
+    for (SDL_GameController *&controller : input->controllers) {
+      if (!controller) {
+        controller = SDL_GameControllerOpen(event->cdevice.which);
+        break;
+      }
+    }
+    return true;
+
+  case SDL_CONTROLLERDEVICEREMOVED:
+    // which is the joystick instance id here, not the device index
+    for (SDL_GameController *&controller : input->controllers) {
+      if (controller &&
+          SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(controller)) ==
+              event->cdevice.which) {
+        SDL_GameControllerClose(controller);
+        controller = NULL;
+      }
+    }
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+uint8_t input_sample(Input *input) {
+  const Uint8 *keys = SDL_GetKeyboardState(NULL);
+  uint8_t held = 0;
+  if (keys[SDL_SCANCODE_LEFT] || keys[SDL_SCANCODE_A]) {
+    held |= INPUT_LEFT;
+  }
+  if (keys[SDL_SCANCODE_RIGHT] || keys[SDL_SCANCODE_D]) {
+    held |= INPUT_RIGHT;
+  }
+  if (keys[SDL_SCANCODE_SPACE]) {
+    held |= INPUT_SHOOT;
+  }
+
+  for (SDL_GameController *controller : input->controllers) {
+    if (!controller) {
+      continue;
+    }
+
+    int stick =
+        SDL_GameControllerGetAxis(controller, SDL_CONTROLLER_AXIS_LEFTX);
+    if (stick <= -INPUT_STICK_DEADZONE ||
+        SDL_GameControllerGetButton(controller,
+                                    SDL_CONTROLLER_BUTTON_DPAD_LEFT)) {
+      held |= INPUT_LEFT;
+    }
+    if (stick >= INPUT_STICK_DEADZONE ||
+        SDL_GameControllerGetButton(controller,
+                                    SDL_CONTROLLER_BUTTON_DPAD_RIGHT)) {
+      held |= INPUT_RIGHT;
+    }
+    if (SDL_GameControllerGetButton(controller, SDL_CONTROLLER_BUTTON_A) ||
+        SDL_GameControllerGetButton(controller, SDL_CONTROLLER_BUTTON_B)) {
+      held |= INPUT_SHOOT;
+    }
+  }
+
+  uint8_t pressed = input->pressed;
+  input->pressed = 0;
+
+  input->event_ns = 0;
+  if (input->evdev.fd >= 0) {
+    input->event_ns =
+        input->evdev.event_ns.exchange(0, std::memory_order_acquire);
+    held |= input->evdev.held.load(std::memory_order_relaxed);
+    pressed |= input->evdev.pressed.exchange(0, std::memory_order_relaxed);
+  }
+
+  // Stick directions have no press events of their own
+  pressed |= held & ~input->last_held;
+  input->last_held = held;
+
+  return held | INPUT_PRESSED(pressed);
+}
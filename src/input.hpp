@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include <SDL2/SDL.h>
+
+#define INPUT_CONTROLLERS 4
+// Stick travel before it counts as a direction, out of 32767
+#define INPUT_STICK_DEADZONE 12000
+
+// An arcade stick read straight from a Linux evdev node. The reader thread
+// blocks on the device and folds each event into atomics as it arrives, so
+// a press lands in the next sample no matter where the frame is. Events
+// carry the kernel's CLOCK_MONOTONIC timestamp, the clock steady_clock
+// uses, so the time from the event to the frame that shows it can be
+// measured.
+struct EvdevInput {
+  int fd = -1;
+  // Written to wake the thread up for shutdown
+  int wake_fd = -1;
+  std::thread thread;
+  // Axis value at or past which the stick counts as left or right
+  int axis_left, axis_right;
+  std::atomic<uint8_t> held{0};
+  std::atomic<uint8_t> pressed{0};
+  // Time of the oldest event not yet sampled, 0 when there is none
+  std::atomic<uint64_t> event_ns{0};
+  std::atomic<uint64_t> events{0};
+};
+
+// Keyboard, SDL game controllers and an optional evdev device, merged into
+// the INPUT_* bitfield tick() reads (see game.hpp)
+struct Input {
+  SDL_GameController *controllers[INPUT_CONTROLLERS];
+  // Presses seen in SDL events since the last sample
+  uint8_t pressed;
+  // Held buttons of the last sample, for presses between two polls
+  uint8_t last_held;
+  EvdevInput evdev;
+  // Timestamp of the oldest evdev event behind the last sample, or 0
+  uint64_t event_ns;
+};
+
+// Starts the controller subsystem, and the evdev reader when evdev_path is
+// given. Controllers already plugged in arrive as events.
+bool input_open(Input *input, const char *evdev_path);
+
+void input_close(Input *input);
+
+// Feeds one SDL event. Returns true when the event was an input event.
+bool input_event(Input *input, const SDL_Event *event);
+
+// Held and newly pressed buttons of every backend, packed as in game.hpp
+uint8_t input_sample(Input *input);
@@ -1,511 +1,397 @@
+#include <algorithm>
+#include <bit>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../include/stb_image.h"
 
-#define SHIP_SPEED 40.0f
+#include "alloc_count.hpp"
+#include "audio.hpp"
+#include "capture.hpp"
+#include "frame_ring.hpp"
+#include "game.hpp"
+#include "input.hpp"
+#include "metrics.hpp"
+#include "pacing.hpp"
+#include "present.hpp"
+#include "text.hpp"
 
-#define SCREEN_WIDTH 224
-#define SCREEN_HEIGHT 256
-
-#define TICKS_PER_SECOND 60
 #define NS_PER_SEC 1000000000
 #define NS_PER_TIC (NS_PER_SEC / TICKS_PER_SECOND)
+#define MAX_TICKS_PER_FRAME 5
 
-#define ROW_HEIGHT 16
-#define ROW_WIDTH SCREEN_WIDTH - 32
-
-#define PADDING 12
-
-enum AlienTypeEnum { CYAN, RED, YELLOW, WHITE };
+#define STARTUP_BUDGET_MS 100
+#define STARTUP_PHASES 16
 
-enum Move { LEFT, RIGHT, DOWN };
+#define HUD_FONT_SIZE 18
+#define HUD_GRAPH_FRAMES 120
 
-struct Vector2f {
-  float x = 0;
-  float y = 0;
-};
-
-struct Vector2i {
-  int x = 0;
-  int y = 0;
-};
+uint64_t steady_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 
-struct Box2f {
-  Vector2f min;
-  Vector2f max;
+// When each startup phase finished, reported once the first frame is up
+struct StartupTimeline {
+  uint64_t start;
+  const char *phase[STARTUP_PHASES];
+  uint64_t at[STARTUP_PHASES];
+  int count;
 };
 
-bool box_collide(Box2f a, Box2f b) {
-  if (((a.min.x >= b.max.x) || (a.max.x <= b.min.x)) ||
-      ((a.min.y >= b.max.y) || (a.max.y <= b.min.y))) {
-    return false;
+void startup_mark(StartupTimeline *timeline, const char *phase) {
+  if (timeline->count < STARTUP_PHASES) {
+    timeline->phase[timeline->count] = phase;
+    timeline->at[timeline->count] = steady_ns();
+    timeline->count++;
   }
-  return true;
 }
 
-struct AlienType {
-  Vector2i index;
-  Vector2i size;
-};
+void startup_report(StartupTimeline *timeline) {
+  uint64_t last = timeline->start;
+  std::cout << "Startup timeline:" << std::endl;
+  for (int i = 0; i < timeline->count; i++) {
+    printf("  %-16s %7.1f ms  (+%.1f ms)\n", timeline->phase[i],
+           (timeline->at[i] - timeline->start) / 1e6,
+           (timeline->at[i] - last) / 1e6);
+    last = timeline->at[i];
+  }
 
-struct Alien {
-  AlienTypeEnum type;
-  int index;
-  Vector2f pos;
-  Move last_move;
-};
+  double total = (last - timeline->start) / 1e6;
+  printf("Startup took %.1f ms%s\n", total,
+         total > STARTUP_BUDGET_MS ? ", over the budget" : "");
+}
 
-struct Projectile {
-  Vector2f pos;
-  bool down;
+// Decoded on a worker thread while SDL brings up the window
+struct AssetLoad {
+  // y-up like the game, for the CPU rasterizer
+  unsigned char *pixels;
+  // Top row first, for the sprite texture
+  std::vector<uint32_t> upright;
+  int width, height;
+  bool ok;
+  uint64_t start, done;
 };
 
-struct Explosion {
-  Vector2f pos;
-  unsigned long long spawn_ns;
-};
+void load_assets(AssetLoad *load) {
+  load->start = steady_ns();
 
-struct Barrier {
-  Vector2f pos;
-  int state;
-};
+  stbi_set_flip_vertically_on_load(true);
+  int channels;
+  load->pixels = stbi_load("Resources/atlas.png", &load->width, &load->height,
+                           &channels, 4);
+  if (!load->pixels) {
+    std::cout << "Failed to load sprite atlas" << std::endl;
+  }
 
-struct {
+  load->ok = load->pixels && load_atlas("Resources/atlas.bin") &&
+             load_stages("Resources/stages.bin");
+  if (load->ok) {
+    build_animations();
+
+    // The window is drawn top row first, so the GPU gets the atlas the way
+    // it is stored on disk
+    const uint32_t *rows = (const uint32_t *)load->pixels;
+    load->upright.resize(load->width * load->height);
+    for (int y = 0; y < load->height; y++) {
+      memcpy(&load->upright[y * load->width],
+             &rows[(load->height - 1 - y) * load->width],
+             load->width * sizeof(uint32_t));
+    }
+  }
+  load->done = steady_ns();
+}
+
+// The window and frame clock around the simulation
+struct : GameState {
   SDL_Window *window;
   SDL_Renderer *renderer;
   SDL_Texture *texture;
   SDL_Texture *sprites;
 
-  Vector2i window_size;
-
-  struct {
-    Vector2f *pos = new Vector2f;
-  } ship;
+  // Atlas pixels kept for the CPU render path
+  const uint32_t *sheet;
+  int sheet_width, sheet_height;
+  // Set when frames are exported with --shm-frames
+  FrameRing frame_ring;
+  // Running when frames are recorded with --capture
+  Capture capture;
+  AudioEngine audio;
+  // Devices behind the GameState::input bits
+  Input controls;
+  FramePacer pacer;
+
+  // Text layer, the debug overlay toggles with F1
+  TextBatch text;
+  bool debug_hud;
+  float frame_ms[HUD_GRAPH_FRAMES];
+  int frame_ms_next;
+
+  Presenter presenter;
+  // What render() draws this frame
+  DrawList draws;
+  // Barrier pixels of the current frame, reserved once so render() does
+  // not allocate
+  std::vector<SDL_Point> barrier_points;
+  // Fraction of a tick since the last one, render() interpolates by it
+  float alpha;
 
   struct {
     unsigned long long last_second;
     unsigned long long last_frame;
-    unsigned long long last_tick;
     unsigned long long tick_remainder;
     unsigned long long delta_ns;
     unsigned long long start;
     unsigned long long now;
-    long double delta;
     int frames;
     int fps;
-  } time;
-
-  struct {
-    struct {
-      bool down, pressed;
-    } left, right, shoot;
-  } input;
-
-  std::vector<Alien *> *aliens;
-  std::vector<Projectile *> *projectiles;
-  std::vector<Explosion *> *explosions;
-  std::vector<Barrier *> *barriers;
-  Move move;
-  Move last_shuffle;
-  float move_ticks;
-  int stage_num_aliens;
-  int lives;
+  } clock;
 } state;
 
-using gameState = decltype(state);
-
-AlienType *alien_sprites(AlienTypeEnum type) {
-
-  AlienType *alien_data = new AlienType;
-
-  switch (type) {
-
-  case AlienTypeEnum::CYAN:
-    alien_data->index = {3, 0};
-    alien_data->size = {8, 8};
-    break;
-
-  case AlienTypeEnum::RED:
-    alien_data->index = {2, 0};
-    alien_data->size = {14, 8};
-    break;
-
-  case AlienTypeEnum::YELLOW:
-    alien_data->index = {2, 1};
-    alien_data->size = {12, 9};
-    break;
-
-  case AlienTypeEnum::WHITE:
-    alien_data->index = {1, 0};
-    alien_data->size = {16, 8};
-    break;
-
-  default:
-    break;
-  }
-
-  return alien_data;
+using appState = decltype(state);
+
+// Game coordinates are y-up, the backbuffer is top row first like the
+// window, so both rects are mirrored vertically here
+void draw_sprite(appState *state, int frame, Vector2f pos) {
+  const AtlasFrame *f = atlas_frame(frame);
+  SDL_Rect src = {f->x, state->sheet_height - f->y - f->h, f->w, f->h};
+  SDL_Rect dst = {int(pos.x) + f->offset_x,
+                  SCREEN_HEIGHT - (int(pos.y) + f->offset_y) - f->h, f->w,
+                  f->h};
+  SDL_RenderCopy(state->renderer, state->sprites, &src, &dst);
 }
 
-void init_stage(gameState *state) {
-
-  int index = 0;
-  for (int y = 0; y < 3; y++) {
-    for (int x = 0; x < 10; x++) {
-      state->aliens->push_back(
-          new Alien({AlienTypeEnum(rand() % 4),
-                     index,
-                     {(float)(10 + x * 14),
-                      (float)SCREEN_HEIGHT - 100 + y * ROW_HEIGHT}}));
-      index++;
-    }
-  }
+// First font that opens: --font, the one shipped next to the sprites,
+// then common monospace system fonts
+const char *hud_fonts[] = {
+    NULL,
+    "Resources/hud.ttf",
+    "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf",
+    "/usr/share/fonts/TTF/DejaVuSansMono.ttf",
+    "/System/Library/Fonts/Menlo.ttc",
+    "C:\\Windows\\Fonts\\consola.ttf",
+};
 
-  for (int y = 0; y < 2; y++) {
-    for (int x = 0; x < 8; x++) {
-      if (y == 0) {
-        state->barriers->push_back(
-            new Barrier({{(float)(10 - 2 + x * 28), (float)(20 + 12 * y)}, 0}));
-      } else {
-        state->barriers->push_back(
-            new Barrier({{(float)(10 - 2 + x * 28), (float)(20 + 12 * y)}, 0}));
-      }
+void hud_render(appState *state, int view_x, int view_w) {
+  TextBatch *text = &state->text;
+  SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+  SDL_Color green = {0x40, 0xFF, 0x40, 0xFF};
+  char line[96];
+
+  snprintf(line, sizeof(line), "SCORE %05d", state->score);
+  text_draw(text, view_x + (view_w - text_width(text, line)) / 2, 8, line,
+            white);
+
+  if (state->debug_hud) {
+    float y = 8;
+    snprintf(line, sizeof(line), "FPS %d", state->clock.fps);
+    text_draw(text, 8, y, line, green);
+    y += text->line_height;
+
+    snprintf(line, sizeof(line), "frame %.2f ms", state->clock.delta_ns / 1e6);
+    text_draw(text, 8, y, line, green);
+    y += text->line_height;
+
+    const PacingStats *pacing = &state->pacer.stats;
+    snprintf(line, sizeof(line), "%s  jitter %.2f ms  missed %d",
+             pacing_mode_name(state->pacer.mode), pacing->jitter_ns / 1e6,
+             pacing->missed);
+    text_draw(text, 8, y, line, green);
+    y += text->line_height;
+
+    snprintf(line, sizeof(line), "aliens %zu  shots %zu",
+             state->world.archetype<AlienArchetype>().size(),
+             state->world.archetype<ProjectileArchetype>().size());
+    text_draw(text, 8, y, line, green);
+    y += text->line_height;
+
+    snprintf(line, sizeof(line), "explosions %d  barriers %zu",
+             state->explosions.count,
+             state->world.archetype<BarrierArchetype>().size());
+    text_draw(text, 8, y, line, green);
+    y += text->line_height + 4;
+
+    // Frame time graph, oldest on the left, full height is 33 ms
+    float graph_h = 60;
+    text_box(text, 8, y, HUD_GRAPH_FRAMES * 2, graph_h, {0, 0, 0, 0xA0});
+    for (int i = 0; i < HUD_GRAPH_FRAMES; i++) {
+      float ms = state->frame_ms[(state->frame_ms_next + i) % HUD_GRAPH_FRAMES];
+      float h = std::min(ms / 33.3f, 1.0f) * graph_h;
+      SDL_Color color = ms > 17.5f ? SDL_Color{0xFF, 0x40, 0x40, 0xFF} : green;
+      text_box(text, 8 + i * 2, y + graph_h - h, 2, h, color);
     }
+    // 60 Hz budget line
+    text_box(text, 8, y + graph_h - graph_h * 16.7f / 33.3f,
+             HUD_GRAPH_FRAMES * 2, 1, white);
   }
 
-  state->stage_num_aliens = state->aliens->size();
-  state->move = Move::RIGHT;
+  text_flush(text, state->renderer);
 }
 
-void tick(gameState *state) {
-  state->move_ticks += 1;
-
-  int Move_speed = 3;
-
-  if (state->move == Move::RIGHT || state->move == Move::LEFT) {
-    state->last_shuffle = state->move;
-  }
-
-  for (int i = 0; i < state->aliens->size(); i++) {
-    if (((int)state->move_ticks + i) % state->aliens->size() == 0) {
-      switch (state->move) {
-      case Move::RIGHT:
-        state->aliens->at(i)->pos.x += Move_speed;
-        break;
-      case Move::LEFT:
-        state->aliens->at(i)->pos.x -= Move_speed;
-        break;
-      case Move::DOWN:
-        state->aliens->at(i)->pos.y -= ROW_HEIGHT;
-        break;
-      }
+void render(appState *state) {
 
-      state->aliens->at(i)->last_move = state->move;
-    }
+  // Render
+  SDL_SetRenderTarget(state->renderer, state->texture);
+  SDL_SetRenderDrawColor(state->renderer, 0, 0, 0, 0);
+  SDL_RenderClear(state->renderer);
 
-    if (rand() % 10000 < 20 || (abs(state->aliens->at(i)->pos.x - state->ship.pos->x) < 4 && (rand() % 100 < 1))) {
-      state->projectiles->push_back(new Projectile(
-          {{state->aliens->at(i)->pos.x + 2, state->aliens->at(i)->pos.y - 2},
-           true}));
-    }
-  }
+  // The same list the CPU rasterizer draws, so the golden image tests
+  // cover what is drawn and where
+  DrawList *list = &state->draws;
+  draw_list_build(state, state->alpha, list);
 
-  bool all_moved = true;
-  for (int i = 0; i < state->aliens->size(); i++) {
-    if (state->aliens->at(i)->last_move != state->move) {
-      all_moved = false;
-      break;
-    }
+  for (int i = 0; i < list->under_barriers; i++) {
+    draw_sprite(state, list->sprites[i].frame, list->sprites[i].pos);
   }
 
-  if (all_moved) {
-    if (state->move == Move::DOWN) {
-      switch (state->last_shuffle) {
-      case Move::LEFT:
-        state->move = Move::RIGHT;
-        break;
-      case Move::RIGHT:
-        state->move = Move::LEFT;
-        break;
-      case Move::DOWN:
-        assert(false);
-        break;
-      default:
-        break;
-      }
-    }
-
-    bool oob = false;
-
-    while (true) {
-      for (int i = 0; i < state->aliens->size(); i++) {
-        switch (state->move) {
-        case Move::RIGHT:
-          if ((state->aliens->at(i)->pos.x + Move_speed) +
-                  alien_sprites(state->aliens->at(i)->type)->size.x >=
-              SCREEN_WIDTH - PADDING) {
-            oob = true;
-            break;
-          }
-          break;
-        case Move::LEFT:
-          if (state->aliens->at(i)->pos.x - Move_speed <= PADDING) {
-            oob = true;
-            break;
-          }
-          break;
-        default:
-          break;
-        }
+  // Barriers are drawn from their bitmaps in a single batch
+  std::vector<SDL_Point> &barrier_points = state->barrier_points;
+  barrier_points.clear();
+  for (int i = 0; i < list->barrier_count; i++) {
+    const BarrierDraw *draw = &list->barriers[i];
+    for (int w = 0; w < BARRIER_WORDS; w++) {
+      uint64_t bits = draw->barrier.bits[w];
+      while (bits) {
+        int bit = std::countr_zero(bits);
+        bits &= bits - 1;
+        barrier_points.push_back(
+            {int(draw->pos.x) + bit % SPRITE_SIZE,
+             SCREEN_HEIGHT - 1 -
+                 (int(draw->pos.y) + w * ROWS_PER_WORD + bit / SPRITE_SIZE)});
       }
-      break;
-    }
-
-    if (oob) {
-      state->move = Move::DOWN;
     }
   }
-}
+  SDL_SetRenderDrawColor(state->renderer, 50, 50, 50, 0xFF);
+  SDL_RenderDrawPoints(state->renderer, barrier_points.data(),
+                       barrier_points.size());
 
-Box2f projectile_box(Projectile projectile) {
-  Box2f box = {projectile.pos,
-               Vector2f({projectile.pos.x + 2, projectile.pos.y + 7})};
-  return box;
-}
-
-Box2f alien_box(Alien alien) {
-  Box2f box = {alien.pos,
-               Vector2f({alien.pos.x + alien_sprites(alien.type)->size.x,
-                         alien.pos.y + alien_sprites(alien.type)->size.y})};
-  return box;
-}
-
-Box2f barrier_box(Barrier barrier) {
-  Vector2f size = {(float)14 - 2 * barrier.state, (float)6 - 2 * barrier.state};
-  Box2f box = {barrier.pos,
-               Vector2f({barrier.pos.x + size.x, barrier.pos.y + size.y})};
-  return box;
-}
-
-Box2f ship_box(gameState *state) {
-  Box2f box = {*state->ship.pos,Vector2f({state->ship.pos->x + 12, state->ship.pos->y + 10})};
-  return box;
-}
-
-void update(gameState *state) {
-
-  if (state->input.left.down) {
-    state->ship.pos->x -= state->time.delta * SHIP_SPEED;
+  for (int i = list->under_barriers; i < list->sprite_count; i++) {
+    draw_sprite(state, list->sprites[i].frame, list->sprites[i].pos);
   }
 
-  if (state->input.right.down) {
-    state->ship.pos->x += state->time.delta * SHIP_SPEED;
-  }
+  presenter_draw(&state->presenter, state->renderer, state->texture);
+  hud_render(state, state->presenter.dst.x, state->presenter.dst.w);
 
-  if (state->input.shoot.pressed) {
-    state->projectiles->push_back(new Projectile(
-        {{state->ship.pos->x + 4, state->ship.pos->y + 11}, false}));
-  }
+  pacing_wait(&state->pacer);
+  SDL_RenderPresent(state->renderer);
+  pacing_presented(&state->pacer);
+}
 
-  for (int i = 0; i < state->projectiles->size(); i++) {
-    if (state->projectiles->at(i)->down) {
-      state->projectiles->at(i)->pos.y -= 100 * state->time.delta;
-    } else {
-      state->projectiles->at(i)->pos.y += 100 * state->time.delta;
+int main(int argc, char *args[]) {
+  StartupTimeline startup = {steady_ns()};
+
+  // The atlas decodes while the window and renderer come up, joined
+  // before the sprite texture is made (or on any early return)
+  AssetLoad assets = {};
+  std::jthread asset_loader(load_assets, &assets);
+
+  const char *evdev_path = NULL;
+  PacingMode pacing = PACING_AUTO;
+  // Started once the atlas is loaded, the encoder draws with it
+  const char *capture_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::string(args[i]) == "--metrics" && i + 1 < argc) {
+      // A kiosk keeps running even if the exporter cannot start
+      metrics_serve(args[++i]);
     }
-  }
 
-  Box2f shipbox = ship_box(state);
-  for(int i = 0; i < state->projectiles->size(); i++) {
-    if (box_collide(shipbox, projectile_box(*state->projectiles->at(i)))) {
-      state->explosions->push_back(new Explosion(
-          {{state->ship.pos->x + 2, state->ship.pos->y + 2},
-           state->time.last_frame}));
-      state->lives -= 1;
-      state->projectiles->erase(state->projectiles->begin() + i);
-
-      if(state->lives == 0) {
-        exit(1);
-      }
+    if (std::string(args[i]) == "--shm-frames" && i + 1 < argc) {
+      frame_ring_open(&state.frame_ring, args[++i]);
     }
-  }
 
-  // Collision projectiles & aliens
-  for (int i = 0; i < state->aliens->size(); i++) {
-    Box2f box = alien_box(*state->aliens->at(i));
-    for (int j = 0; j < state->projectiles->size(); j++) {
-      if (box_collide(box, projectile_box(*state->projectiles->at(j))) and
-          !state->projectiles->at(j)->down) {
-        state->explosions->push_back(new Explosion(
-            {{state->aliens->at(i)->pos.x + 2, state->aliens->at(i)->pos.y + 2},
-             state->time.last_frame}));
-        state->projectiles->erase(state->projectiles->begin() + j);
-        if (state->aliens->at(i) != NULL) {
-          state->aliens->erase(state->aliens->begin() + i);
-        }
-      }
+    if (std::string(args[i]) == "--capture" && i + 1 < argc) {
+      capture_path = args[++i];
     }
-    
-    if (box_collide(box, shipbox)) {
-      state->aliens->erase(state->aliens->begin() + i);
-      state->explosions->push_back(new Explosion(
-          {{state->aliens->at(i)->pos.x + 2, state->aliens->at(i)->pos.y + 2},
-           state->time.last_frame}));
-
-      state->explosions->push_back(
-          new Explosion({{state->ship.pos->x + 2, state->ship.pos->y + 2},
-                         state->time.last_frame}));
-      state->lives -= 1;
-      state->projectiles->erase(state->projectiles->begin() + i);
-
-      if (state->lives == 0) {
-        exit(1);
-      }
-    }
-  }
 
-  for (int i = 0; i < state->projectiles->size(); i++) {
-    Box2f box = projectile_box( * state->projectiles->at(i));
-    for (int j = 0; j < state->barriers->size(); j++) {
-      if (state->projectiles->at(i)->down == true) {
-        if(box_collide(box, barrier_box(*state->barriers->at(j)))) {
-          state->barriers->at(j)->state += 1;
-          state->projectiles->erase(state->projectiles->begin() + i);
-        }
-      }
+    if (std::string(args[i]) == "--font" && i + 1 < argc) {
+      hud_fonts[0] = args[++i];
     }
-  }
 
-  // Remove barriers
-  for (int i = 0; i < state->barriers->size(); i++) {
-    if (state->barriers->at(i)->state >= 4) {
-      state->barriers->erase(state->barriers->begin() + i);
+    if (std::string(args[i]) == "--evdev" && i + 1 < argc) {
+      evdev_path = args[++i];
     }
-  }
-}
-
-SDL_Rect *makeRect(int x, int y, int w, int h) {
-  SDL_Rect *rect = new SDL_Rect;
-  rect->x = x;
-  rect->y = y;
-  rect->w = w;
-  rect->h = h;
-  return rect;
-}
-
-void draw_sprite(gameState *state, Vector2i index, Vector2f pos) {
-  const int SPRITE_SIZE = 16;
-
-  SDL_RenderCopy(state->renderer, state->sprites,
-                 makeRect(index.x * SPRITE_SIZE, index.y * SPRITE_SIZE,
-                          SPRITE_SIZE, SPRITE_SIZE),
-                 makeRect(int(pos.x), int(pos.y), SPRITE_SIZE, SPRITE_SIZE));
-}
-
-void render(gameState *state) {
 
-  // Render
-  SDL_SetRenderTarget(state->renderer, state->texture);
-  SDL_SetRenderDrawColor(state->renderer, 0, 0, 0, 0);
-  SDL_RenderClear(state->renderer);
-
-  for (int i = 0; i < state->aliens->size(); i++) {
-    draw_sprite(state, alien_sprites(state->aliens->at(i)->type)->index,
-                state->aliens->at(i)->pos);
-  }
-
-  for (int i = 0; i < state->projectiles->size(); i++) {
-    draw_sprite(state, Vector2i({1, int(state->time.now) % 2 + 1}),
-                state->projectiles->at(i)->pos);
-  }
-
-  for (int i = 0; i < state->barriers->size(); i++) {
-    draw_sprite(state, Vector2i({state->barriers->at(i)->state, 3}), state->barriers->at(i)->pos);
-  }
-
-  for (int i = 0; i < state->explosions->size(); i++) {
-    int frame = (state->time.last_frame - state->explosions->at(i)->spawn_ns) /
-                (0.25 * NS_PER_SEC);
-    if (frame < 2) {
-      draw_sprite(state, Vector2i({0, 1 + frame}),
-                  state->explosions->at(i)->pos);
-    } else {
-      state->explosions->erase(state->explosions->begin() + i);
+    if (std::string(args[i]) == "--integer-scale") {
+      state.presenter.integer_scale = true;
     }
-  }
 
-  for(int i = 0; i < state->lives; i++) {
-    draw_sprite(state, Vector2i({0, 0}),
-                Vector2f({(float)2 + 11 * i, (float)2}));
+    if (std::string(args[i]) == "--pacing" && i + 1 < argc) {
+      pacing = pacing_mode_parse(args[++i]);
+    }
   }
+  startup_mark(&startup, "options");
 
-  // Draw ship
-
-  state->ship.pos->y = 4;
-  draw_sprite(state, Vector2i{0, 0}, *state->ship.pos);
-
-  float screen_scale = (float)state->window_size.y / (float)SCREEN_HEIGHT;
-
-  // Draw texture to screen
-  SDL_SetRenderTarget(state->renderer, NULL);
-  SDL_SetRenderDrawColor(state->renderer, 20, 20, 20, 0xFF);
-  SDL_RenderCopyEx(
-      state->renderer, state->texture,
-      makeRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT),
-      makeRect(
-          (int)((state->window_size.x - int(SCREEN_WIDTH * screen_scale)) / 2),
-          0, (int)((float)SCREEN_WIDTH * screen_scale), state->window_size.y),
-      0, NULL, SDL_FLIP_VERTICAL);
-  SDL_RenderPresent(state->renderer);
-}
-
-int main(int argc, char *args[]) {
-
-  srand(time(NULL));
-
-  const Uint8 *keystates;
-
-  if (SDL_Init(SDL_INIT_EVERYTHING)) {
+  // Video brings in events, nothing else is used
+  if (SDL_Init(SDL_INIT_VIDEO)) {
     std::cout << "SDL_Init failed with error: " << SDL_GetError() << std::endl;
-    exit(1);
-  }
-
-  if (IMG_Init(IMG_INIT_PNG) != IMG_INIT_PNG) {
-    std::cout << "Failed to initialize SDL_image" << SDL_GetError()
-              << std::endl;
-    exit(1);
+    return -1;
   }
+  startup_mark(&startup, "sdl init");
 
   // Create window
   SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
   state.window =
       SDL_CreateWindow("スパースインベーダー!", SDL_WINDOWPOS_UNDEFINED,
-                       SDL_WINDOWPOS_UNDEFINED, 1600, 900, SDL_WINDOW_SHOWN);
+                       SDL_WINDOWPOS_UNDEFINED, 1600, 900,
+                       SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
 
   if (!state.window) {
     std::cout << "Failed to create window" << std::endl;
     return -1;
   }
+  startup_mark(&startup, "window");
 
-  // Create renderer
-  state.renderer =
-      SDL_CreateRenderer(state.window, -1,
-                         SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE |
-                             SDL_RENDERER_PRESENTVSYNC);
+  // Create renderer, vsync is up to the frame pacer
+  state.renderer = SDL_CreateRenderer(
+      state.window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
 
   if (!state.renderer) {
     std::cout << "Failed to create renderer" << std::endl;
     return -1;
   }
+  pacing_init(&state.pacer, state.window, state.renderer, pacing);
+  presenter_layout(&state.presenter, state.renderer);
+  startup_mark(&startup, "renderer");
+
+  // Without a font the game still runs, only the text is missing
+  if (TTF_Init() == 0) {
+    const char **font = hud_fonts;
+    const char **end = hud_fonts + sizeof(hud_fonts) / sizeof(*hud_fonts);
+    while (font < end &&
+           !(*font && text_open(&state.text, state.renderer, *font,
+                                HUD_FONT_SIZE))) {
+      font++;
+    }
+    if (font == end) {
+      std::cout << "No HUD font found, pass one with --font" << std::endl;
+    }
+  } else {
+    std::cout << "Failed to initialize SDL_ttf: " << SDL_GetError()
+              << std::endl;
+  }
+  startup_mark(&startup, "fonts");
+
+  // The game runs silent when there is no audio device
+  audio_open(&state.audio);
+  startup_mark(&startup, "audio");
+
+  // Keyboard always works, controllers and the stick are extras
+  input_open(&state.controls, evdev_path);
+  startup_mark(&startup, "input");
 
   // Create backbuffer
   state.texture =
@@ -516,21 +402,22 @@ int main(int argc, char *args[]) {
     std::cout << "Failed to create texture" << std::endl;
     return -1;
   }
+  startup_mark(&startup, "backbuffer");
 
-  // load sprites
-  stbi_set_flip_vertically_on_load(true);
-
-  int width, height, channels;
-  unsigned char *data =
-      stbi_load("Resources/spritesheet.png", &width, &height, &channels, 4);
+  asset_loader.join();
+  startup_mark(&startup, "assets");
 
-  if (!data) {
-    std::cout << "Failed to load spritesheet" << std::endl;
+  if (!assets.ok) {
     return -1;
   }
 
+  unsigned char *data = assets.pixels;
+  int width = assets.width;
+  int height = assets.height;
+
   SDL_Surface *sprite_surface = SDL_CreateRGBSurfaceWithFormatFrom(
-      data, width, height, 32, (width * 4), (SDL_PIXELFORMAT_ABGR8888));
+      assets.upright.data(), width, height, 32, (width * 4),
+      (SDL_PIXELFORMAT_ABGR8888));
 
   if (!sprite_surface) {
     std::cout << "Failed to create surface" << std::endl;
@@ -538,6 +425,9 @@ int main(int argc, char *args[]) {
   }
 
   state.sprites = SDL_CreateTextureFromSurface(state.renderer, sprite_surface);
+  state.sheet = (const uint32_t *)data;
+  state.sheet_width = width;
+  state.sheet_height = height;
 
   if (!state.sprites) {
     std::cout << "Failed to create texture from surface" << SDL_GetError()
@@ -545,19 +435,24 @@ int main(int argc, char *args[]) {
     return -1;
   }
 
-  state.aliens = new std::vector<Alien *>();
-  state.projectiles = new std::vector<Projectile *>();
-  state.explosions = new std::vector<Explosion *>();
-  state.barriers = new std::vector<Barrier *>();
-  state.lives = 3;
-
   SDL_SetTextureColorMod(state.sprites, 0xFF, 0xFF, 0xFF);
   SDL_SetTextureAlphaMod(state.sprites, 0xFF);
 
-  init_stage(&state);
+  startup_mark(&startup, "sprites");
+
+  if (capture_path) {
+    capture_start(&state.capture, capture_path, state.sheet,
+                  state.sheet_width);
+  }
+
+  game_reset(&state, time(NULL));
+  state.barrier_points.reserve(MAX_BARRIER_ROWS * BARRIER_COLUMNS *
+                               SPRITE_SIZE * SPRITE_SIZE);
+  startup_mark(&startup, "game");
 
   SDL_Event event;
   bool quit = false;
+  bool first_frame = true;
 
   while (quit == false) {
 
@@ -567,89 +462,153 @@ int main(int argc, char *args[]) {
             .time_since_epoch()
             .count();
 
-    if (state.time.start == 0) {
-      state.time.start = now;
+    if (state.clock.start == 0) {
+      state.clock.start = now;
     }
 
-    state.time.now = (now - state.time.start) / NS_PER_SEC;
+    state.clock.now = (now - state.clock.start) / NS_PER_SEC;
 
-    if (state.time.last_frame == 0) {
-      state.time.last_frame = now;
+    if (state.clock.last_frame == 0) {
+      state.clock.last_frame = now;
     }
 
-    state.time.delta_ns = now - state.time.last_frame;
-    state.time.delta =
-        (long double)(state.time.delta_ns / (long double)NS_PER_SEC);
-    state.time.last_frame = now;
-    state.time.frames += 1;
-
-    if ((now - state.time.last_second) > NS_PER_SEC) {
-      state.time.last_second = now;
-      state.time.fps = state.time.frames;
-      state.time.frames = 0;
-      std::cout << "FPS: " << state.time.fps << std::endl;
+    state.clock.delta_ns = now - state.clock.last_frame;
+    state.clock.last_frame = now;
+    state.clock.frames += 1;
+    state.frame_ms[state.frame_ms_next] = state.clock.delta_ns / 1e6;
+    state.frame_ms_next = (state.frame_ms_next + 1) % HUD_GRAPH_FRAMES;
+
+    if ((now - state.clock.last_second) > NS_PER_SEC) {
+      state.clock.last_second = now;
+      state.clock.fps = state.clock.frames;
+      state.clock.frames = 0;
+      std::cout << "FPS: " << state.clock.fps << std::endl;
+    }
+
+    while (SDL_PollEvent(&event)) {
+      if (input_event(&state.controls, &event)) {
+        continue;
+      }
+
+      switch (event.type) {
+      case SDL_QUIT:
+        quit = true;
+        break;
+
+      case SDL_KEYDOWN:
+        if (event.key.keysym.sym == SDLK_F1) {
+          state.debug_hud = !state.debug_hud;
+        }
+        break;
+
+      case SDL_WINDOWEVENT:
+        if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+          presenter_layout(&state.presenter, state.renderer);
+        }
+        break;
+
+      default:
+        break;
+      }
     }
 
+    // Sampled after the events so taps since the last frame are in. Presses
+    // no tick has seen yet are kept for the next one.
+    state.input = (state.input & INPUT_PRESSED(INPUT_BUTTONS)) |
+                  input_sample(&state.controls);
+
     unsigned long long tick_time =
-        state.time.tick_remainder + state.time.delta_ns;
+        state.clock.tick_remainder + state.clock.delta_ns;
+    int ticks_run = 0;
     while (tick_time > NS_PER_TIC) {
-      std::cout << "Tick time remaining: " << state.time.tick_remainder
-                << std::endl;
       tick_time -= NS_PER_TIC;
+
+      // After a long stall drop the backlog instead of freezing to catch up
+      if (ticks_run == MAX_TICKS_PER_FRAME) {
+        metrics.dropped_ticks.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
       tick(&state);
+      metrics.ticks.fetch_add(1, std::memory_order_relaxed);
+      ticks_run++;
+
+      // A press counts on one tick, the later ones only see it held
+      state.input &= INPUT_BUTTONS;
     }
-    state.time.tick_remainder = tick_time;
-    std::cout << "Tick time remaining: " << state.time.tick_remainder
-              << std::endl;
+    state.clock.tick_remainder = tick_time;
 
-    keystates = SDL_GetKeyboardState(NULL);
+    // How far into the next tick this frame is shown
+    state.alpha = (float)state.clock.tick_remainder / NS_PER_TIC;
 
-    bool left =
-        bool(keystates[SDL_SCANCODE_LEFT]) || bool(keystates[SDL_SCANCODE_A]);
-    bool right =
-        bool(keystates[SDL_SCANCODE_RIGHT]) || bool(keystates[SDL_SCANCODE_D]);
-    bool shoot = bool(keystates[SDL_SCANCODE_SPACE]);
+    for (int i = 0; i < state.sounds.count; i++) {
+      audio_play(&state.audio, SoundId(state.sounds.ids[i]));
+    }
+    state.sounds.count = 0;
 
-    state.input.left = {left, left};
-    state.input.right = {right, right};
-    state.input.shoot = {shoot, shoot};
+    render(&state);
 
-    while (SDL_PollEvent(&event)) {
-      switch (event.type) {
-      case SDL_QUIT:
-        quit = true;
-        break;
+    // Stick to screen: from the kernel's event timestamp to present
+    if (state.controls.event_ns) {
+      metrics_record_input_latency(steady_ns() - state.controls.event_ns);
+    }
 
-      case SDL_KEYDOWN:
-        switch (event.key.keysym.sym) {
-        case SDLK_a:
-        case SDLK_LEFT:
-          state.input.left.pressed = true;
-          break;
-
-        case SDLK_d:
-        case SDLK_RIGHT:
-          state.input.right.pressed = true;
-          break;
-
-        case SDLK_SPACE:
-          state.input.shoot.pressed = true;
-          break;
-
-        default:
-          break;
-        }
+    if (first_frame) {
+      first_frame = false;
+      startup_mark(&startup, "first frame");
+      startup_report(&startup);
+      printf("  (atlas decoded on a worker in %.1f ms)\n",
+             (assets.done - assets.start) / 1e6);
+    }
+
+    // Rendered straight into the shared ring, readers map it in place
+    if (state.frame_ring.header) {
+      uint32_t *frame = frame_ring_begin(&state.frame_ring);
+      raster_frame(&state, state.sheet, state.sheet_width, frame);
+      frame_ring_publish(&state.frame_ring);
+    }
+
+    // Only the draw list is copied here, the encoder thread rasterizes it
+    // and does the rest. A full queue drops the frame.
+    if (state.capture.running.load(std::memory_order_relaxed)) {
+      if (DrawList *slot = capture_begin(&state.capture)) {
+        draw_list_build(&state, 1, slot);
+        capture_submit(&state.capture, state.time.ticks);
       }
     }
 
-    int w, h;
-    SDL_GetWindowSize(state.window, &w, &h);
-    state.window_size = Vector2i{w, h};
+    if (state.game_over) {
+      quit = true;
+    }
 
-    update(&state);
-    render(&state);
+    metrics_record_frame(state.clock.delta_ns);
+    // Only the game thread's own allocations, so leaks and per-frame churn
+    // show up on the dashboards without the metrics server formatting a
+    // scrape or the capture encoder counting against the game loop
+    metrics.allocations.store(thread_allocations(),
+                              std::memory_order_relaxed);
+    metrics.frame_jitter_ns.store(state.pacer.stats.jitter_ns,
+                                  std::memory_order_relaxed);
+    metrics.missed_frames.store(state.pacer.missed_total,
+                                std::memory_order_relaxed);
+    metrics.aliens.store(state.world.archetype<AlienArchetype>().size(),
+                         std::memory_order_relaxed);
+    metrics.projectiles.store(
+        state.world.archetype<ProjectileArchetype>().size(),
+        std::memory_order_relaxed);
+    metrics.explosions.store(state.explosions.count,
+                             std::memory_order_relaxed);
+    metrics.barriers.store(state.world.archetype<BarrierArchetype>().size(),
+                           std::memory_order_relaxed);
   }
 
+  metrics_stop();
+  frame_ring_close(&state.frame_ring);
+  capture_stop(&state.capture);
+  audio_close(&state.audio);
+  input_close(&state.controls);
+  text_close(&state.text);
+  TTF_Quit();
+
   SDL_DestroyTexture(state.texture);
   SDL_DestroyWindow(state.window);
   SDL_DestroyRenderer(state.renderer);
@@ -0,0 +1,65 @@
+#include "march.hpp"
+
+#include <algorithm>
+
+// Points of the speed curve, aliens left against ticks per step, with
+// straight lines in between. Ticks never exceed aliens, so every tick of
+// a step moves at least one alien.
+static const struct {
+  int aliens, ticks;
+} march_curve[] = {{1, 1}, {8, 8}, {ALIEN_ROWS * ALIEN_COLUMNS, 20}};
+
+#define MARCH_CURVE_POINTS (int)(sizeof(march_curve) / sizeof(*march_curve))
+
+void march_reset(MarchCursor *march) { *march = {}; }
+
+int march_step_ticks(int num_aliens) {
+  if (num_aliens <= march_curve[0].aliens) {
+    return march_curve[0].ticks;
+  }
+
+  for (int i = 1; i < MARCH_CURVE_POINTS; i++) {
+    if (num_aliens <= march_curve[i].aliens) {
+      int da = march_curve[i].aliens - march_curve[i - 1].aliens;
+      int dt = march_curve[i].ticks - march_curve[i - 1].ticks;
+      return march_curve[i - 1].ticks +
+             (num_aliens - march_curve[i - 1].aliens) * dt / da;
+    }
+  }
+  return march_curve[MARCH_CURVE_POINTS - 1].ticks;
+}
+
+int march_advance(MarchCursor *march, int num_aliens, int *first) {
+  march->next -= march->killed;
+  march->killed = 0;
+
+  if (march->next >= num_aliens) {
+    march->next = 0;
+  }
+
+  if (march->next == 0) {
+    march->step_ticks = march_step_ticks(num_aliens);
+    march->credit = 0;
+  }
+
+  march->credit += num_aliens;
+  int count = std::min(march->credit / march->step_ticks,
+                       num_aliens - march->next);
+  march->credit %= march->step_ticks;
+
+  *first = march->next;
+  march->next += count;
+  return count;
+}
+
+bool march_step_done(const MarchCursor *march, int num_aliens) {
+  return march->next - march->killed >= num_aliens;
+}
+
+void march_kill(MarchCursor *march, int row) {
+  // Rows are compared against the cursor as it was before this batch of
+  // kills, since none of them are compacted away yet
+  if (row < march->next) {
+    march->killed++;
+  }
+}
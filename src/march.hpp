@@ -0,0 +1,40 @@
+#pragma once
+
+#include "components.hpp"
+
+// Walks the formation a few aliens per tick, like the arcade game where a
+// step of the whole formation takes longer the more aliens are left. The
+// alien archetype keeps its rows in index order, so a cursor into the
+// column is enough to know whose turn it is: rows before next have moved
+// in the current step.
+//
+// How long a step takes comes from a speed curve over the live count,
+// and the aliens of a step are spread over its ticks with an integer
+// accumulator, so each tick moves one or more aliens in O(1).
+struct MarchCursor {
+  // First row not yet moved in the current step
+  int next;
+  // Kills in front of the cursor since the last advance
+  int killed;
+  // Ticks the current step takes, from the speed curve
+  int step_ticks;
+  int credit;
+};
+
+void march_reset(MarchCursor *march);
+
+// Ticks a formation step takes with num_aliens left
+int march_step_ticks(int num_aliens);
+
+// Rows [*first, *first + count) move this tick, count is returned. A
+// first of 0 means a new step of the formation starts.
+int march_advance(MarchCursor *march, int num_aliens, int *first);
+
+// True once every one of num_aliens took the current step, counting the
+// kills the next advance still has to take off the cursor. Ask before the
+// advance, since it starts the next step right away.
+bool march_step_done(const MarchCursor *march, int num_aliens);
+
+// Call when the alien in row is destroyed, before the world is flushed,
+// so the cursor stays on the same alien once rows are compacted
+void march_kill(MarchCursor *march, int row);
@@ -0,0 +1,251 @@
+#include "metrics.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+Metrics metrics;
+
+// Upper bounds in nanoseconds, the last bucket is +Inf
+static const uint64_t frame_time_bounds[FRAME_TIME_BUCKETS - 1] = {
+    4000000, 8000000, 16666667, 33333333, 50000000, 100000000};
+
+// Heap allocated so the early error returns in main(), which skip
+// metrics_stop(), do not run the destructor of a joinable thread
+static std::thread *server = NULL;
+static std::atomic<bool> server_running{false};
+static int server_fd = -1;
+static std::string server_path;
+
+// A scraper gets this long to send its request and take the response
+// before the server moves on
+#define CLIENT_TIMEOUT_MS 1000
+
+void metrics_record_frame(uint64_t frame_ns) {
+  metrics.frames.fetch_add(1, std::memory_order_relaxed);
+  metrics.frame_time_ns.store(frame_ns, std::memory_order_relaxed);
+  metrics.frame_time_ns_sum.fetch_add(frame_ns, std::memory_order_relaxed);
+
+  int bucket = 0;
+  while (bucket < FRAME_TIME_BUCKETS - 1 &&
+         frame_ns > frame_time_bounds[bucket]) {
+    bucket++;
+  }
+  metrics.frame_time_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void metrics_record_input_latency(uint64_t latency_ns) {
+  metrics.input_latency_ns.store(latency_ns, std::memory_order_relaxed);
+  metrics.input_latency_ns_sum.fetch_add(latency_ns,
+                                         std::memory_order_relaxed);
+  metrics.input_latency_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void write_metric(std::string *out, const char *name, const char *type,
+                         const char *help, std::string value) {
+  *out += std::string("# HELP ") + name + " " + help + "\n";
+  *out += std::string("# TYPE ") + name + " " + type + "\n";
+  *out += std::string(name) + " " + value + "\n";
+}
+
+static std::string format_metrics() {
+  std::string out;
+
+  auto load = [](auto &value) {
+    return std::to_string(value.load(std::memory_order_relaxed));
+  };
+  auto seconds = [](auto &value) {
+    return std::to_string(value.load(std::memory_order_relaxed) / 1e9);
+  };
+
+  write_metric(&out, "invaders_frames_total", "counter", "Frames rendered.",
+               load(metrics.frames));
+  write_metric(&out, "invaders_ticks_total", "counter",
+               "Fixed simulation ticks run.", load(metrics.ticks));
+  write_metric(&out, "invaders_dropped_ticks_total", "counter",
+               "Ticks skipped because a frame fell too far behind.",
+               load(metrics.dropped_ticks));
+  write_metric(&out, "invaders_allocations_total", "counter",
+               "Calls to global operator new on the game thread.",
+               load(metrics.allocations));
+  write_metric(&out, "invaders_frame_time_seconds_last", "gauge",
+               "Duration of the last frame.",
+               seconds(metrics.frame_time_ns));
+  write_metric(&out, "invaders_frame_jitter_seconds", "gauge",
+               "Standard deviation of recent present intervals.",
+               seconds(metrics.frame_jitter_ns));
+  write_metric(&out, "invaders_missed_frames_total", "counter",
+               "Presents more than half a frame late.",
+               load(metrics.missed_frames));
+  write_metric(&out, "invaders_aliens", "gauge", "Live aliens.",
+               load(metrics.aliens));
+  write_metric(&out, "invaders_projectiles", "gauge", "Live projectiles.",
+               load(metrics.projectiles));
+  write_metric(&out, "invaders_explosions", "gauge", "Live explosions.",
+               load(metrics.explosions));
+  write_metric(&out, "invaders_barriers", "gauge", "Remaining barriers.",
+               load(metrics.barriers));
+
+  out += "# HELP invaders_frame_time_seconds Frame duration.\n";
+  out += "# TYPE invaders_frame_time_seconds histogram\n";
+  uint64_t count = 0;
+  for (int i = 0; i < FRAME_TIME_BUCKETS; i++) {
+    count += metrics.frame_time_buckets[i].load(std::memory_order_relaxed);
+    std::string le = i < FRAME_TIME_BUCKETS - 1
+                         ? std::to_string(frame_time_bounds[i] / 1e9)
+                         : "+Inf";
+    out += "invaders_frame_time_seconds_bucket{le=\"" + le + "\"} " +
+           std::to_string(count) + "\n";
+  }
+  out += "invaders_frame_time_seconds_sum " +
+         seconds(metrics.frame_time_ns_sum) + "\n";
+  out += "invaders_frame_time_seconds_count " + std::to_string(count) + "\n";
+
+  out += "# HELP invaders_input_latency_seconds Evdev event to present.\n";
+  out += "# TYPE invaders_input_latency_seconds summary\n";
+  out += "invaders_input_latency_seconds_sum " +
+         seconds(metrics.input_latency_ns_sum) + "\n";
+  out += "invaders_input_latency_seconds_count " +
+         load(metrics.input_latency_count) + "\n";
+  write_metric(&out, "invaders_input_latency_seconds_last", "gauge",
+               "Latency of the last evdev event.",
+               seconds(metrics.input_latency_ns));
+
+  return out;
+}
+
+static void serve_client(int client) {
+  // A client that connects and then stalls must not hold up the only
+  // server thread, or metrics_stop() with it
+  timeval timeout = {CLIENT_TIMEOUT_MS / 1000, CLIENT_TIMEOUT_MS % 1000 * 1000};
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  // The request itself is ignored, every path returns the same page
+  char request[1024];
+  if (recv(client, request, sizeof(request), 0) < 0) {
+    close(client);
+    return;
+  }
+
+  std::string body = format_metrics();
+  std::string response = "HTTP/1.0 200 OK\r\n"
+                         "Content-Type: text/plain; version=0.0.4\r\n"
+                         "Content-Length: " +
+                         std::to_string(body.size()) + "\r\n\r\n" + body;
+
+  size_t sent = 0;
+  while (sent < response.size()) {
+    // A scraper that hung up would otherwise raise SIGPIPE and end the game
+    ssize_t n = send(client, response.data() + sent, response.size() - sent,
+                     MSG_NOSIGNAL);
+    if (n <= 0) {
+      break;
+    }
+    sent += n;
+  }
+  close(client);
+}
+
+static void server_loop() {
+  while (server_running.load()) {
+    pollfd fd = {server_fd, POLLIN, 0};
+    if (poll(&fd, 1, 100) <= 0) {
+      continue;
+    }
+
+    int client = accept(server_fd, NULL, NULL);
+    if (client >= 0) {
+      serve_client(client);
+    }
+  }
+}
+
+// Closes the listening socket and removes its path, if any
+static void server_close() {
+  if (server_fd >= 0) {
+    close(server_fd);
+    server_fd = -1;
+  }
+  if (!server_path.empty()) {
+    unlink(server_path.c_str());
+    server_path.clear();
+  }
+}
+
+bool metrics_serve(const char *address) {
+  if (server_running.load()) {
+    return false;
+  }
+
+  char *end;
+  long port = strtol(address, &end, 10);
+
+  if (*end == '\0') {
+    // htons() would silently truncate anything larger, and port 0 binds
+    // some free port nobody knows
+    if (end == address || port < 1 || port > 65535) {
+      std::cout << "Invalid metrics port " << address << std::endl;
+      return false;
+    }
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int reuse = 1;
+    server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd < 0 ||
+        setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &reuse,
+                   sizeof(reuse)) ||
+        bind(server_fd, (sockaddr *)&addr, sizeof(addr))) {
+      std::cout << "Failed to bind metrics port " << address << std::endl;
+      server_close();
+      return false;
+    }
+  } else {
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, address, sizeof(addr.sun_path) - 1);
+
+    unlink(address);
+    server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server_fd < 0 || bind(server_fd, (sockaddr *)&addr, sizeof(addr))) {
+      std::cout << "Failed to bind metrics socket " << address << std::endl;
+      server_close();
+      return false;
+    }
+    server_path = address;
+  }
+
+  if (listen(server_fd, 4)) {
+    std::cout << "Failed to listen on metrics socket" << std::endl;
+    server_close();
+    return false;
+  }
+
+  server_running = true;
+  server = new std::thread(server_loop);
+  return true;
+}
+
+void metrics_stop() {
+  if (!server_running.exchange(false)) {
+    return;
+  }
+
+  server->join();
+  delete server;
+  server = NULL;
+  server_close();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#define FRAME_TIME_BUCKETS 7
+
+// Process-wide counters and gauges. The game loop only does relaxed atomic
+// stores and adds, so recording never blocks on a scrape in progress.
+struct Metrics {
+  std::atomic<uint64_t> frames{0};
+  std::atomic<uint64_t> ticks{0};
+  std::atomic<uint64_t> dropped_ticks{0};
+  std::atomic<uint64_t> allocations{0};
+
+  std::atomic<uint64_t> frame_time_ns{0};
+  std::atomic<uint64_t> frame_time_ns_sum{0};
+  std::atomic<uint64_t> frame_time_buckets[FRAME_TIME_BUCKETS] = {};
+  // From the frame pacer, over its last window of presents
+  std::atomic<uint64_t> frame_jitter_ns{0};
+  std::atomic<uint64_t> missed_frames{0};
+
+  // Evdev event to the first frame presented after it
+  std::atomic<uint64_t> input_latency_ns{0};
+  std::atomic<uint64_t> input_latency_ns_sum{0};
+  std::atomic<uint64_t> input_latency_count{0};
+
+  std::atomic<int64_t> aliens{0};
+  std::atomic<int64_t> projectiles{0};
+  std::atomic<int64_t> explosions{0};
+  std::atomic<int64_t> barriers{0};
+};
+
+extern Metrics metrics;
+
+void metrics_record_frame(uint64_t frame_ns);
+
+void metrics_record_input_latency(uint64_t latency_ns);
+
+// Starts a background thread answering HTTP requests with the metrics in
+// Prometheus text format. address is either a TCP port on 127.0.0.1 or the
+// path of a Unix socket. Returns false when the socket cannot be opened.
+bool metrics_serve(const char *address);
+void metrics_stop();
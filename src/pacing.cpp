@@ -0,0 +1,184 @@
+#include "pacing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "game.hpp"
+
+static uint64_t pacing_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Applies mode to the renderer, false when the driver cannot do it
+static bool pacing_apply(FramePacer *pacer, PacingMode mode) {
+  switch (mode) {
+  case PACING_VSYNC:
+    if (SDL_RenderSetVSync(pacer->renderer, 1)) {
+      return false;
+    }
+    break;
+
+  case PACING_ADAPTIVE: {
+    // SDL2 only exposes late swap tearing through GL swap intervals
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(pacer->renderer, &info) ||
+        strncmp(info.name, "opengl", 6) != 0 ||
+        SDL_RenderSetVSync(pacer->renderer, 1) ||
+        SDL_GL_SetSwapInterval(-1)) {
+      return false;
+    }
+    break;
+  }
+
+  case PACING_LIMITER:
+    SDL_RenderSetVSync(pacer->renderer, 0);
+    pacer->deadline = 0;
+    break;
+
+  case PACING_AUTO:
+    return false;
+  }
+
+  pacer->mode = mode;
+  std::cout << "Frame pacing: " << pacing_mode_name(mode) << std::endl;
+  return true;
+}
+
+void pacing_init(FramePacer *pacer, SDL_Window *window,
+                 SDL_Renderer *renderer, PacingMode mode) {
+  *pacer = {};
+  pacer->renderer = renderer;
+  pacer->target_ns = 1000000000 / TICKS_PER_SECOND;
+
+  SDL_DisplayMode display = {};
+  if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(window), &display) ==
+          0 &&
+      display.refresh_rate > 0) {
+    pacer->refresh_ns = 1000000000 / display.refresh_rate;
+  }
+
+  if (mode != PACING_AUTO) {
+    pacer->forced = true;
+    if (pacing_apply(pacer, mode)) {
+      return;
+    }
+    std::cout << "Frame pacing " << pacing_mode_name(mode)
+              << " is not supported here" << std::endl;
+  }
+
+  // render() interpolates between ticks, so vsync is smooth at any refresh
+  // rate the display reports. Without one there is nothing to sync to.
+  if (pacer->refresh_ns && (pacing_apply(pacer, PACING_ADAPTIVE) ||
+                            pacing_apply(pacer, PACING_VSYNC))) {
+    return;
+  }
+  pacing_apply(pacer, PACING_LIMITER);
+}
+
+void pacing_wait(FramePacer *pacer) {
+  if (pacer->mode != PACING_LIMITER) {
+    return;
+  }
+
+  uint64_t now = pacing_now();
+
+  // First frame, or more than a frame behind: start over from now rather
+  // than rushing through the backlog
+  if (pacer->deadline == 0 || now > pacer->deadline + pacer->target_ns) {
+    pacer->deadline = now + pacer->target_ns;
+    return;
+  }
+
+  if (pacer->deadline > now + PACING_SPIN_NS) {
+    std::this_thread::sleep_for(
+        std::chrono::nanoseconds(pacer->deadline - now - PACING_SPIN_NS));
+  }
+  while (pacing_now() < pacer->deadline) {
+  }
+  pacer->deadline += pacer->target_ns;
+}
+
+// Statistics over the full window, and a change of mode when auto picked
+// vsync but the presents say otherwise
+static void pacing_evaluate(FramePacer *pacer, uint64_t expected) {
+  double sum = 0, sum_sq = 0;
+  uint64_t max = 0;
+  int missed = 0;
+  for (uint64_t interval : pacer->intervals) {
+    sum += interval;
+    sum_sq += double(interval) * interval;
+    max = std::max(max, interval);
+    missed += interval > expected * 3 / 2;
+  }
+
+  double mean = sum / PACING_WINDOW;
+  pacer->stats.mean_ns = mean;
+  pacer->stats.jitter_ns =
+      std::sqrt(std::max(0.0, sum_sq / PACING_WINDOW - mean * mean));
+  pacer->stats.max_ns = max;
+  pacer->stats.missed = missed;
+
+  if (pacer->forced || pacer->mode == PACING_LIMITER || !pacer->refresh_ns) {
+    return;
+  }
+
+  // Presents returning faster than the display refreshes mean the driver
+  // or compositor ignores vsync
+  if (mean < pacer->refresh_ns * 3 / 4) {
+    pacing_apply(pacer, PACING_LIMITER);
+  } else if (pacer->mode == PACING_VSYNC && missed > PACING_WINDOW / 10) {
+    // Late frames wait a whole extra vblank, tearing is the lesser evil
+    pacing_apply(pacer, PACING_ADAPTIVE);
+  }
+}
+
+void pacing_presented(FramePacer *pacer) {
+  uint64_t now = pacing_now();
+  if (pacer->last_present == 0) {
+    pacer->last_present = now;
+    return;
+  }
+
+  uint64_t interval = now - pacer->last_present;
+  pacer->last_present = now;
+
+  uint64_t expected = pacer->mode == PACING_LIMITER || !pacer->refresh_ns
+                          ? pacer->target_ns
+                          : pacer->refresh_ns;
+  pacer->missed_total += interval > expected * 3 / 2;
+
+  pacer->intervals[pacer->next] = interval;
+  pacer->next = (pacer->next + 1) % PACING_WINDOW;
+  if (pacer->next == 0) {
+    pacing_evaluate(pacer, expected);
+  }
+}
+
+const char *pacing_mode_name(PacingMode mode) {
+  switch (mode) {
+  case PACING_AUTO:
+    return "auto";
+  case PACING_VSYNC:
+    return "vsync";
+  case PACING_ADAPTIVE:
+    return "adaptive";
+  case PACING_LIMITER:
+    return "limiter";
+  }
+  return "auto";
+}
+
+PacingMode pacing_mode_parse(const char *name) {
+  for (PacingMode mode : {PACING_VSYNC, PACING_ADAPTIVE, PACING_LIMITER}) {
+    if (strcmp(name, pacing_mode_name(mode)) == 0) {
+      return mode;
+    }
+  }
+  return PACING_AUTO;
+}
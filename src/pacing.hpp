@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+#include <SDL2/SDL.h>
+
+// Present intervals kept for the statistics, two seconds at 60 Hz
+#define PACING_WINDOW 120
+// The limiter sleeps until this long before the deadline and spins the
+// rest, since sleeps wake up late by up to a scheduler quantum
+#define PACING_SPIN_NS 1500000
+
+enum PacingMode {
+  // Pick one from the display and switch if present timing disagrees
+  PACING_AUTO,
+  // Wait for every vblank
+  PACING_VSYNC,
+  // Wait for the vblank, but present right away when a frame missed it
+  PACING_ADAPTIVE,
+  // No vsync, sleep then spin until the next tick boundary
+  PACING_LIMITER,
+};
+
+struct PacingStats {
+  uint64_t mean_ns;
+  // Standard deviation of the present interval
+  uint64_t jitter_ns;
+  uint64_t max_ns;
+  // Presents in the window that came more than half a period late
+  int missed;
+};
+
+// Decides how frames are paced and measures how well that works. The
+// window is PACING_WINDOW present intervals in a ring, the stats are
+// refreshed each time it wraps.
+struct FramePacer {
+  SDL_Renderer *renderer;
+  PacingMode mode;
+  // Set when the mode came from the command line, never switched then
+  bool forced;
+  // Vblank period of the display, 0 when unknown
+  uint64_t refresh_ns;
+  // Interval the limiter paces to
+  uint64_t target_ns;
+  uint64_t deadline;
+  uint64_t last_present;
+  uint64_t intervals[PACING_WINDOW];
+  int next;
+  PacingStats stats;
+  uint64_t missed_total;
+};
+
+// The renderer must be created without SDL_RENDERER_PRESENTVSYNC, the
+// pacer turns vsync on when it picks a mode that uses it
+void pacing_init(FramePacer *pacer, SDL_Window *window,
+                 SDL_Renderer *renderer, PacingMode mode);
+
+// Right before SDL_RenderPresent. Only waits in limiter mode.
+void pacing_wait(FramePacer *pacer);
+
+// Right after SDL_RenderPresent
+void pacing_presented(FramePacer *pacer);
+
+const char *pacing_mode_name(PacingMode mode);
+
+// "auto", "vsync", "adaptive" or "limiter", PACING_AUTO for anything else
+PacingMode pacing_mode_parse(const char *name);
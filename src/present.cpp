@@ -0,0 +1,35 @@
+#include "present.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "game.hpp"
+
+void presenter_layout(Presenter *presenter, SDL_Renderer *renderer) {
+  // Output pixels rather than window points, they differ on HiDPI screens
+  int w, h;
+  if (SDL_GetRendererOutputSize(renderer, &w, &h)) {
+    w = SCREEN_WIDTH;
+    h = SCREEN_HEIGHT;
+  }
+  presenter->output_w = w;
+  presenter->output_h = h;
+
+  float scale = std::min(float(w) / SCREEN_WIDTH, float(h) / SCREEN_HEIGHT);
+  // A window smaller than the game falls back to fractional scaling
+  if (presenter->integer_scale && scale >= 1) {
+    scale = std::floor(scale);
+  }
+
+  int dst_w = int(SCREEN_WIDTH * scale);
+  int dst_h = int(SCREEN_HEIGHT * scale);
+  presenter->dst = {(w - dst_w) / 2, (h - dst_h) / 2, dst_w, dst_h};
+}
+
+void presenter_draw(const Presenter *presenter, SDL_Renderer *renderer,
+                    SDL_Texture *backbuffer) {
+  SDL_SetRenderTarget(renderer, NULL);
+  SDL_SetRenderDrawColor(renderer, 20, 20, 20, 0xFF);
+  SDL_RenderClear(renderer);
+  SDL_RenderCopy(renderer, backbuffer, NULL, &presenter->dst);
+}
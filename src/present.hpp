@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+// Where the backbuffer lands in the window: centered, scaled to fit and
+// letterboxed with bars. The layout only depends on the output size, so
+// it is computed at startup and on SDL_WINDOWEVENT_SIZE_CHANGED instead
+// of every frame.
+struct Presenter {
+  // Only whole multiples of the backbuffer size, so every game pixel is
+  // the same number of screen pixels
+  bool integer_scale;
+  int output_w, output_h;
+  SDL_Rect dst;
+};
+
+// Reads the renderer's output size and lays the backbuffer out in it
+void presenter_layout(Presenter *presenter, SDL_Renderer *renderer);
+
+// Clears the window to the bar color and copies backbuffer into dst. The
+// render target is the window afterwards.
+void presenter_draw(const Presenter *presenter, SDL_Renderer *renderer,
+                    SDL_Texture *backbuffer);
@@ -0,0 +1,136 @@
+#include "raster.hpp"
+
+#include <algorithm>
+#include <bit>
+
+// Game coordinates are y-up, the frame is stored top row first
+static inline uint32_t *pixel_at(uint32_t *pixels, int x, int y) {
+  return &pixels[(SCREEN_HEIGHT - 1 - y) * SCREEN_WIDTH + x];
+}
+
+static inline uint32_t blend(uint32_t dst, uint32_t src) {
+  uint32_t a = src >> 24;
+  if (a == 0xFF) {
+    return src;
+  }
+  if (a == 0) {
+    return dst;
+  }
+
+  uint32_t out = 0xFF000000;
+  for (int shift = 0; shift < 24; shift += 8) {
+    uint32_t s = (src >> shift) & 0xFF;
+    uint32_t d = (dst >> shift) & 0xFF;
+    out |= ((s * a + d * (255 - a)) / 255) << shift;
+  }
+  return out;
+}
+
+static void raster_sprite(const uint32_t *sheet, int sheet_width, int frame,
+                          Vector2f pos, uint32_t *pixels) {
+  const AtlasFrame *f = atlas_frame(frame);
+  int left = int(pos.x) + f->offset_x;
+  int bottom = int(pos.y) + f->offset_y;
+
+  int x0 = std::max(0, -left);
+  int x1 = std::min<int>(f->w, SCREEN_WIDTH - left);
+  int y0 = std::max(0, -bottom);
+  int y1 = std::min<int>(f->h, SCREEN_HEIGHT - bottom);
+
+  if (x0 >= x1 || y0 >= y1) {
+    return;
+  }
+
+  // Row pointers start at the first visible column, one at left would
+  // point outside the frame when the sprite is clipped on that side
+  for (int y = y0; y < y1; y++) {
+    const uint32_t *src = &sheet[(f->y + y) * sheet_width + f->x + x0];
+    uint32_t *dst = pixel_at(pixels, left + x0, bottom + y);
+    for (int x = 0; x < x1 - x0; x++) {
+      dst[x] = blend(dst[x], src[x]);
+    }
+  }
+}
+
+static void draw_list_sprite(DrawList *list, int frame, Vector2f pos) {
+  if (list->sprite_count < DRAW_MAX_SPRITES) {
+    list->sprites[list->sprite_count++] = {frame, pos};
+  }
+}
+
+void draw_list_build(GameState *state, float alpha, DrawList *list) {
+  list->sprite_count = 0;
+  list->barrier_count = 0;
+
+  state->world.each<Position, Sprite, Alien>(
+      [&](Entity, Position &pos, Sprite &sprite, Alien &) {
+        draw_list_sprite(list, current_frame(state, sprite), pos);
+      });
+
+  // Weighted so an alpha of 1 gives pos exactly
+  state->world.each<Position, PrevPosition, Sprite>(
+      [&](Entity, Position &pos, PrevPosition &prev, Sprite &sprite) {
+        Vector2f at = {pos.x * alpha + prev.x * (1 - alpha),
+                       pos.y * alpha + prev.y * (1 - alpha)};
+        draw_list_sprite(list, current_frame(state, sprite), at);
+      });
+  list->under_barriers = list->sprite_count;
+
+  state->world.each<Position, Barrier>(
+      [&](Entity, Position &pos, Barrier &barrier) {
+        if (list->barrier_count < DRAW_MAX_BARRIERS) {
+          list->barriers[list->barrier_count++] = {pos, barrier};
+        }
+      });
+
+  for (int i = 0; i < state->explosions.count; i++) {
+    int slot = explosion_slot(&state->explosions, i);
+    draw_list_sprite(
+        list, state->explosions.frame[slot],
+        Vector2f({state->explosions.x[slot], state->explosions.y[slot]}));
+  }
+
+  for (int i = 0; i < state->lives; i++) {
+    draw_list_sprite(list, sprite_frame(SPRITE_SHIP, 0),
+                     Vector2f({(float)2 + 11 * i, (float)2}));
+  }
+}
+
+void raster_draw_list(const DrawList *list, const uint32_t *sheet,
+                      int sheet_width, uint32_t *pixels) {
+  std::fill(pixels, pixels + FRAME_PIXELS, rgba(0, 0, 0, 0xFF));
+
+  for (int i = 0; i < list->under_barriers; i++) {
+    raster_sprite(sheet, sheet_width, list->sprites[i].frame,
+                  list->sprites[i].pos, pixels);
+  }
+
+  uint32_t barrier_color = rgba(50, 50, 50, 0xFF);
+  for (int i = 0; i < list->barrier_count; i++) {
+    const BarrierDraw *draw = &list->barriers[i];
+    for (int w = 0; w < BARRIER_WORDS; w++) {
+      uint64_t bits = draw->barrier.bits[w];
+      while (bits) {
+        int bit = std::countr_zero(bits);
+        bits &= bits - 1;
+        int x = int(draw->pos.x) + bit % SPRITE_SIZE;
+        int y = int(draw->pos.y) + w * ROWS_PER_WORD + bit / SPRITE_SIZE;
+        if (x >= 0 && x < SCREEN_WIDTH && y >= 0 && y < SCREEN_HEIGHT) {
+          *pixel_at(pixels, x, y) = barrier_color;
+        }
+      }
+    }
+  }
+
+  for (int i = list->under_barriers; i < list->sprite_count; i++) {
+    raster_sprite(sheet, sheet_width, list->sprites[i].frame,
+                  list->sprites[i].pos, pixels);
+  }
+}
+
+void raster_frame(GameState *state, const uint32_t *sheet, int sheet_width,
+                  uint32_t *pixels) {
+  DrawList list;
+  draw_list_build(state, 1, &list);
+  raster_draw_list(&list, sheet, sheet_width, pixels);
+}
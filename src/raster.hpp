@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game.hpp"
+
+#define FRAME_PIXELS (SCREEN_WIDTH * SCREEN_HEIGHT)
+
+// Packs a colour the way the atlas pixels are stored: R, G, B, A bytes
+inline uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+  return uint32_t(r) | uint32_t(g) << 8 | uint32_t(b) << 16 |
+         uint32_t(a) << 24;
+}
+
+// Sprites a frame can show: the formation, shots, the ship, explosions and
+// the lives. Shots past MAX_PROJECTILES are left out.
+#define DRAW_MAX_SPRITES                                                       \
+  (ALIEN_ROWS * ALIEN_COLUMNS + MAX_PROJECTILES + 1 + MAX_EXPLOSIONS +         \
+   START_LIVES)
+#define DRAW_MAX_BARRIERS (MAX_BARRIER_ROWS * BARRIER_COLUMNS)
+
+struct SpriteDraw {
+  int frame;
+  Vector2f pos;
+};
+
+struct BarrierDraw {
+  Vector2f pos;
+  Barrier barrier;
+};
+
+// What a frame shows, copied out of the game state. render() draws it
+// with SDL, raster_draw_list() on the CPU, and the capture encoder thread
+// from its own copy. Sprites before under_barriers are drawn, then the
+// barriers, then the rest.
+struct DrawList {
+  SpriteDraw sprites[DRAW_MAX_SPRITES];
+  int sprite_count;
+  int under_barriers;
+  BarrierDraw barriers[DRAW_MAX_BARRIERS];
+  int barrier_count;
+};
+
+// The ship and shots are placed alpha of the way from their position at
+// the start of the last tick to the current one, aliens keep the arcade's
+// discrete steps. An alpha of 1 draws the state as it is.
+void draw_list_build(GameState *state, float alpha, DrawList *list);
+
+void raster_draw_list(const DrawList *list, const uint32_t *sheet,
+                      int sheet_width, uint32_t *pixels);
+
+// Software version of render() for consumers that need the pixels on the
+// CPU, the draw list at alpha 1 rasterized into SCREEN_WIDTH x
+// SCREEN_HEIGHT RGBA pixels, top row first as the window shows it. sheet
+// is the atlas image as loaded for the GPU path (flipped on load),
+// sheet_width pixels wide.
+void raster_frame(GameState *state, const uint32_t *sheet, int sheet_width,
+                  uint32_t *pixels);
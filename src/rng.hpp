@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// xorshift64* generator. Every game owns one, so a seed replays the same
+// game and instances running side by side do not share hidden state.
+struct Rng {
+  uint64_t state;
+};
+
+inline void rng_seed(Rng *rng, uint64_t seed) {
+  // splitmix64 step so nearby seeds start far apart and never at zero
+  uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  z ^= z >> 31;
+  rng->state = z ? z : 1;
+}
+
+inline uint32_t rng_next(Rng *rng) {
+  rng->state ^= rng->state >> 12;
+  rng->state ^= rng->state << 25;
+  rng->state ^= rng->state >> 27;
+  return uint32_t((rng->state * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+// Uniform in the open interval (0, 1)
+inline double rng_uniform(Rng *rng) {
+  return (rng_next(rng) + 1.0) / 4294967297.0;
+}
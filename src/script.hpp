@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game.hpp"
+
+// Scripted input for headless replays, the benchmarks and the golden
+// tests. Each step holds input (INPUT_* bits) for ticks ticks, and the
+// script loops.
+struct ScriptStep {
+  int ticks;
+  uint8_t input;
+};
+
+#define SCRIPT_STEPS(script) int(sizeof(script) / sizeof(*script))
+
+// Sweeps the ship across the barriers while firing, with pauses so the
+// formation gets to shoot back
+inline const ScriptStep sweep_script[] = {
+    {90, INPUT_RIGHT | INPUT_SHOOT}, {30, INPUT_SHOOT},
+    {150, INPUT_LEFT | INPUT_SHOOT}, {45, 0},
+    {60, INPUT_RIGHT},               {20, INPUT_SHOOT},
+};
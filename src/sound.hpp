@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+#define MAX_SOUND_EVENTS 32
+
+// The march beat cycles through four notes like the arcade game
+enum SoundId {
+  SOUND_SHOOT,
+  SOUND_ALIEN_EXPLOSION,
+  SOUND_SHIP_EXPLOSION,
+  SOUND_MARCH_1,
+  SOUND_MARCH_2,
+  SOUND_MARCH_3,
+  SOUND_MARCH_4,
+  SOUND_COUNT
+};
+
+// Sounds the simulation asked for since the consumer last cleared count.
+// When nobody listens (headless runs) it fills up and drops the rest.
+struct SoundEvents {
+  uint8_t ids[MAX_SOUND_EVENTS];
+  int count;
+};
+
+inline void sound_emit(SoundEvents *events, SoundId id) {
+  if (events->count < MAX_SOUND_EVENTS) {
+    events->ids[events->count++] = id;
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded queue for exactly one producer thread and one consumer thread.
+// No locks and no allocation after construction, so it is safe to use from
+// a real-time callback. Capacity must be a power of two.
+template <typename T, size_t Capacity> class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  // Producer only. False when the queue is full.
+  bool push(const T &item) {
+    uint64_t head = this->head.load(std::memory_order_relaxed);
+    if (head - tail_cache == Capacity) {
+      tail_cache = tail.load(std::memory_order_acquire);
+      if (head - tail_cache == Capacity) {
+        return false;
+      }
+    }
+    items[head & (Capacity - 1)] = item;
+    this->head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. False when the queue is empty.
+  bool pop(T *item) {
+    uint64_t tail = this->tail.load(std::memory_order_relaxed);
+    if (tail == head_cache) {
+      head_cache = head.load(std::memory_order_acquire);
+      if (tail == head_cache) {
+        return false;
+      }
+    }
+    *item = items[tail & (Capacity - 1)];
+    this->tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  // Each side keeps the other's index cached on its own cache line
+  alignas(64) std::atomic<uint64_t> head{0};
+  uint64_t tail_cache = 0;
+  alignas(64) std::atomic<uint64_t> tail{0};
+  uint64_t head_cache = 0;
+  alignas(64) T items[Capacity];
+};
@@ -0,0 +1,39 @@
+#include "stage.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+Stages stages;
+
+bool load_stages(const char *path) {
+  FILE *file = fopen(path, "rb");
+
+  if (!file) {
+    std::cout << "Failed to open " << path << std::endl;
+    return false;
+  }
+
+  bool ok = fread(&stages.header, sizeof(StageHeader), 1, file) == 1 &&
+            memcmp(stages.header.magic, STAGE_MAGIC, 4) == 0 &&
+            stages.header.version == STAGE_VERSION &&
+            stages.header.stage_count > 0;
+
+  if (ok) {
+    stages.defs.resize(stages.header.stage_count);
+    ok = fread(stages.defs.data(), sizeof(StageDef), stages.defs.size(),
+               file) == stages.defs.size();
+  }
+
+  fclose(file);
+
+  if (!ok) {
+    std::cout << "Invalid or outdated stage file " << path << std::endl;
+  }
+  return ok;
+}
+
+const StageDef *stage_def(int wave) {
+  return &stages.defs[std::min<int>(wave, stages.defs.size() - 1)];
+}
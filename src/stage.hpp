@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "components.hpp"
+
+#define STAGE_MAGIC "SIST"
+#define STAGE_VERSION 1
+
+// Cell values besides an AlienTypeEnum
+#define STAGE_RANDOM 0xFE
+#define STAGE_EMPTY 0xFF
+
+#define BARRIER_COLUMNS 8
+#define MAX_BARRIER_ROWS 2
+
+// On-disk layout of stages.bin, written by tools/stage_packer.cpp from
+// stages.txt: one StageHeader then stage_count StageDef. Fields are 8 and
+// 16-bit little endian so the structs have no padding.
+struct StageHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t stage_count;
+  // Largest alien and barrier counts of any stage, for preallocation
+  uint16_t max_aliens;
+  uint16_t max_barriers;
+};
+
+// One wave. types[row][column] uses row 0 for the row closest to the ship,
+// like Alien::index.
+struct StageDef {
+  uint8_t march_speed;
+  uint8_t fire_mean_ticks;
+  uint8_t barrier_rows;
+  uint8_t reserved;
+  // Height of row 0
+  int16_t bottom_y;
+  uint16_t alien_count;
+  uint8_t types[ALIEN_ROWS][ALIEN_COLUMNS];
+};
+
+struct Stages {
+  StageHeader header;
+  std::vector<StageDef> defs;
+};
+
+extern Stages stages;
+
+bool load_stages(const char *path);
+
+// Wave n plays stage n, and the last stage repeats once they run out
+const StageDef *stage_def(int wave);
@@ -0,0 +1,164 @@
+#include "text.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+bool text_open(TextBatch *text, SDL_Renderer *renderer, const char *path,
+               int size) {
+  TTF_Font *font = TTF_OpenFont(path, size);
+  if (!font) {
+    return false;
+  }
+
+  // Render every glyph first to size the grid cells
+  SDL_Surface *surfaces[GLYPH_COUNT] = {};
+  int cell_w = 1, cell_h = 1;
+  SDL_Color white = {0xFF, 0xFF, 0xFF, 0xFF};
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    SDL_Surface *glyph = TTF_RenderGlyph_Blended(font, GLYPH_FIRST + i, white);
+    if (glyph) {
+      surfaces[i] =
+          SDL_ConvertSurfaceFormat(glyph, SDL_PIXELFORMAT_ARGB8888, 0);
+      if (surfaces[i] != glyph) {
+        SDL_FreeSurface(glyph);
+      }
+    }
+    if (surfaces[i]) {
+      cell_w = std::max(cell_w, surfaces[i]->w);
+      cell_h = std::max(cell_h, surfaces[i]->h);
+    }
+  }
+
+  int rows = (GLYPH_COUNT + GLYPH_COLUMNS - 1) / GLYPH_COLUMNS;
+  // One extra row holds the solid block
+  text->width = GLYPH_COLUMNS * cell_w;
+  text->height = (rows + 1) * cell_h;
+  text->line_height = TTF_FontHeight(font);
+  std::vector<uint32_t> pixels(text->width * text->height, 0);
+
+  for (int i = 0; i < GLYPH_COUNT; i++) {
+    int x = (i % GLYPH_COLUMNS) * cell_w;
+    int y = (i / GLYPH_COLUMNS) * cell_h;
+    int advance = cell_w;
+    TTF_GlyphMetrics(font, GLYPH_FIRST + i, NULL, NULL, NULL, NULL, &advance);
+
+    SDL_Surface *glyph = surfaces[i];
+    text->glyphs[i] = {{x, y, glyph ? glyph->w : 0, glyph ? glyph->h : 0},
+                       advance};
+    if (!glyph) {
+      continue;
+    }
+
+    for (int row = 0; row < glyph->h; row++) {
+      memcpy(&pixels[(y + row) * text->width + x],
+             (uint8_t *)glyph->pixels + row * glyph->pitch,
+             glyph->w * sizeof(uint32_t));
+    }
+    SDL_FreeSurface(glyph);
+  }
+  TTF_CloseFont(font);
+
+  // 2x2 white block sampled at its center for solid quads
+  int solid_y = rows * cell_h;
+  for (int y = 0; y < 2; y++) {
+    for (int x = 0; x < 2; x++) {
+      pixels[(solid_y + y) * text->width + x] = 0xFFFFFFFF;
+    }
+  }
+  text->solid = {1.0f / text->width, (solid_y + 1.0f) / text->height};
+
+  text->texture =
+      SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                        SDL_TEXTUREACCESS_STATIC, text->width, text->height);
+  if (!text->texture) {
+    std::cout << "Failed to create glyph texture: " << SDL_GetError()
+              << std::endl;
+    return false;
+  }
+  SDL_UpdateTexture(text->texture, NULL, pixels.data(),
+                    text->width * sizeof(uint32_t));
+  SDL_SetTextureBlendMode(text->texture, SDL_BLENDMODE_BLEND);
+
+  text->vertices.reserve(TEXT_BATCH_QUADS * 4);
+  text->indices.reserve(TEXT_BATCH_QUADS * 6);
+  return true;
+}
+
+void text_close(TextBatch *text) {
+  if (text->texture) {
+    SDL_DestroyTexture(text->texture);
+    text->texture = NULL;
+  }
+}
+
+static void text_quad(TextBatch *text, float x, float y, float w, float h,
+                      float u0, float v0, float u1, float v1,
+                      SDL_Color color) {
+  int base = text->vertices.size();
+  text->vertices.push_back({{x, y}, color, {u0, v0}});
+  text->vertices.push_back({{x + w, y}, color, {u1, v0}});
+  text->vertices.push_back({{x + w, y + h}, color, {u1, v1}});
+  text->vertices.push_back({{x, y + h}, color, {u0, v1}});
+
+  static const int corners[] = {0, 1, 2, 0, 2, 3};
+  for (int corner : corners) {
+    text->indices.push_back(base + corner);
+  }
+}
+
+static const Glyph *text_glyph(const TextBatch *text, char c) {
+  int i = (unsigned char)c - GLYPH_FIRST;
+  if (i < 0 || i >= GLYPH_COUNT) {
+    i = '?' - GLYPH_FIRST;
+  }
+  return &text->glyphs[i];
+}
+
+float text_width(const TextBatch *text, const char *string) {
+  float width = 0;
+  for (const char *c = string; *c; c++) {
+    width += text_glyph(text, *c)->advance;
+  }
+  return width;
+}
+
+float text_draw(TextBatch *text, float x, float y, const char *string,
+                SDL_Color color) {
+  if (!text->texture) {
+    return 0;
+  }
+
+  float start = x;
+  for (const char *c = string; *c; c++) {
+    const Glyph *glyph = text_glyph(text, *c);
+    if (glyph->rect.w > 0 && *c != ' ') {
+      const SDL_Rect &r = glyph->rect;
+      text_quad(text, x, y, r.w, r.h, float(r.x) / text->width,
+                float(r.y) / text->height, float(r.x + r.w) / text->width,
+                float(r.y + r.h) / text->height, color);
+    }
+    x += glyph->advance;
+  }
+  return x - start;
+}
+
+void text_box(TextBatch *text, float x, float y, float w, float h,
+              SDL_Color color) {
+  if (!text->texture) {
+    return;
+  }
+  text_quad(text, x, y, w, h, text->solid.x, text->solid.y, text->solid.x,
+            text->solid.y, color);
+}
+
+void text_flush(TextBatch *text, SDL_Renderer *renderer) {
+  if (!text->vertices.empty()) {
+    SDL_RenderGeometry(renderer, text->texture, text->vertices.data(),
+                       text->vertices.size(), text->indices.data(),
+                       text->indices.size());
+  }
+  // Capacity stays, so steady state frames do not allocate
+  text->vertices.clear();
+  text->indices.clear();
+}
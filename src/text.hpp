@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#define GLYPH_FIRST 32
+#define GLYPH_COUNT 95
+#define GLYPH_COLUMNS 16
+#define TEXT_BATCH_QUADS 2048
+
+struct Glyph {
+  SDL_Rect rect;
+  int advance;
+};
+
+// Printable ASCII rasterized once into a single texture, with a white
+// texel for solid boxes and graphs. Strings and boxes queue up as quads
+// and go out in one SDL_RenderGeometry call, so changing text costs no
+// TTF_Render* calls or surface allocations at runtime.
+struct TextBatch {
+  SDL_Texture *texture;
+  Glyph glyphs[GLYPH_COUNT];
+  SDL_FPoint solid;
+  int width, height;
+  int line_height;
+  std::vector<SDL_Vertex> vertices;
+  std::vector<int> indices;
+};
+
+// Rasterizes the glyphs of the font at path. Needs TTF_Init().
+bool text_open(TextBatch *text, SDL_Renderer *renderer, const char *path,
+               int size);
+
+void text_close(TextBatch *text);
+
+// Queues a string at (x, y), the top left corner, and returns its width
+float text_draw(TextBatch *text, float x, float y, const char *string,
+                SDL_Color color);
+
+// Width of a string without drawing it
+float text_width(const TextBatch *text, const char *string);
+
+// Queues a solid rectangle
+void text_box(TextBatch *text, float x, float y, float w, float h,
+              SDL_Color color);
+
+// Draws everything queued since the last flush
+void text_flush(TextBatch *text, SDL_Renderer *renderer);
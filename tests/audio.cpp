@@ -0,0 +1,141 @@
+// Mixer tests without an audio device. Builds the sample bank, posts
+// commands with audio_play() through the command queue and calls
+// audio_mix() the way the SDL callback does, then checks the mixed
+// samples, voices ending, voice stealing when the pool is full and
+// commands dropped when the queue is full.
+//
+// usage: audio
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "../src/audio.hpp"
+
+static int failed;
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    std::cout << "FAIL " << __func__ << ": " << #cond << std::endl;            \
+    failed++;                                                                  \
+  }
+
+// A fresh engine that queues commands as if a device were open
+static void audio_reset(AudioEngine *audio) {
+  // Also stops every voice
+  audio_build_bank(audio);
+  AudioCommand command;
+  while (audio->commands.pop(&command)) {
+  }
+  audio->dropped.store(0);
+  audio->device = 1;
+}
+
+static int active_voices(const AudioEngine *audio) {
+  int count = 0;
+  for (const Voice &voice : audio->voices) {
+    count += voice.samples != NULL;
+  }
+  return count;
+}
+
+// The mix of two voices is the sum of their scaled samples, and each voice
+// is freed once its sample has played
+static void test_mix(AudioEngine *audio) {
+  audio_reset(audio);
+  const std::vector<int16_t> &shoot = audio->bank[SOUND_SHOOT];
+  const std::vector<int16_t> &march = audio->bank[SOUND_MARCH_1];
+  CHECK(!shoot.empty() && !march.empty());
+
+  std::vector<int16_t> out(AUDIO_BUFFER_FRAMES, 1);
+  audio_mix(audio, out.data(), out.size());
+  CHECK(std::count(out.begin(), out.end(), 0) == int(out.size()));
+
+  audio_play(audio, SOUND_SHOOT);
+  audio_play(audio, SOUND_MARCH_1, 128);
+  CHECK(active_voices(audio) == 0);
+
+  int frames = std::max(shoot.size(), march.size()) + AUDIO_BUFFER_FRAMES;
+  out.assign(frames, 0);
+  audio_mix(audio, out.data(), frames);
+  CHECK(active_voices(audio) == 0);
+
+  int wrong = 0;
+  for (int i = 0; i < frames; i++) {
+    int32_t sum = 0;
+    if (i < int(shoot.size())) {
+      sum += shoot[i] * 255 >> 8;
+    }
+    if (i < int(march.size())) {
+      sum += march[i] * 128 >> 8;
+    }
+    wrong += out[i] != std::clamp<int32_t>(sum, INT16_MIN, INT16_MAX);
+  }
+  CHECK(wrong == 0);
+}
+
+// With every voice busy a new sound replaces the one closest to finishing
+static void test_steal(AudioEngine *audio) {
+  audio_reset(audio);
+  int16_t out[8];
+
+  // Each voice is started 8 frames after the previous one, so voice 0 has
+  // the least left to play
+  for (int i = 0; i < AUDIO_VOICES; i++) {
+    audio_play(audio, SOUND_SHIP_EXPLOSION);
+    audio_mix(audio, out, 8);
+  }
+  CHECK(active_voices(audio) == AUDIO_VOICES);
+  CHECK(audio->voices[0].position == AUDIO_VOICES * 8);
+
+  audio_play(audio, SOUND_SHOOT);
+  audio_mix(audio, out, 8);
+  CHECK(active_voices(audio) == AUDIO_VOICES);
+  CHECK(audio->voices[0].samples == audio->bank[SOUND_SHOOT].data());
+  CHECK(audio->voices[0].position == 8);
+  for (int i = 1; i < AUDIO_VOICES; i++) {
+    CHECK(audio->voices[i].samples ==
+          audio->bank[SOUND_SHIP_EXPLOSION].data());
+  }
+}
+
+// Commands past the queue capacity are counted and dropped, the rest still
+// play, and nothing is queued without a device
+static void test_queue_full(AudioEngine *audio) {
+  audio_reset(audio);
+  for (int i = 0; i < AUDIO_COMMANDS + 5; i++) {
+    audio_play(audio, SOUND_MARCH_2);
+  }
+  CHECK(audio->dropped.load() == 5);
+
+  int16_t out[8];
+  audio_mix(audio, out, 8);
+  CHECK(active_voices(audio) == AUDIO_VOICES);
+
+  // The queue is empty again after the mix
+  audio_play(audio, SOUND_SHOOT);
+  CHECK(audio->dropped.load() == 5);
+
+  audio_reset(audio);
+  audio->device = 0;
+  audio_play(audio, SOUND_SHOOT);
+  audio_mix(audio, out, 8);
+  CHECK(active_voices(audio) == 0);
+  CHECK(audio->dropped.load() == 0);
+}
+
+int main() {
+  AudioEngine audio;
+
+  test_mix(&audio);
+  test_steal(&audio);
+  test_queue_full(&audio);
+
+  if (failed) {
+    std::cout << failed << " audio checks failed" << std::endl;
+    return 1;
+  }
+  std::cout << "Audio mixer checks passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,356 @@
+// Property tests for the simulation step. Plays games from random seeds
+// with random input and checks after every tick that the state is still
+// consistent: entity counts within what game_reset reserved, alien indices
+// in range and sorted, the fire and march schedules in step with the
+// aliens, the formation inside the screen and turning only between steps,
+// finite positions, time moving one tick at a time and no allocations
+// inside tick().
+//
+// A case is a byte string: an 8 byte seed, then pairs of an INPUT_* byte
+// and a run length, the input being held for length + 1 ticks. The same
+// cases come from a random generator here, or from libFuzzer when built
+// with -DFUZZ_LIBFUZZER -fsanitize=fuzzer (make fuzz-libfuzzer).
+//
+// usage: fuzz [cases] [seed]    random cases, prints ticks per second
+//        fuzz file...           replays saved cases
+//
+// A failing random case is written to fuzz-failure.bin for replaying.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "../src/alloc_count.hpp"
+#include "../src/game.hpp"
+
+#define FUZZ_FAILURE "fuzz-failure.bin"
+// Input runs per random case, up to about 20000 ticks
+#define FUZZ_MAX_RUNS 400
+
+// The case being run, saved when a property fails
+static const uint8_t *case_data;
+static size_t case_size;
+static bool save_failures;
+// Time spent in tick() alone, without the checks
+static uint64_t tick_ns;
+
+static uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void fail(const GameState *state, uint64_t seed, const char *what) {
+  std::cout << "FAIL seed " << seed << " tick " << state->time.ticks << ": "
+            << what << std::endl;
+  if (save_failures) {
+    FILE *file = fopen(FUZZ_FAILURE, "wb");
+    if (file) {
+      fwrite(case_data, 1, case_size, file);
+      fclose(file);
+      std::cout << "Case written to " << FUZZ_FAILURE << std::endl;
+    }
+  }
+  abort();
+}
+
+#define CHECK(cond)                                                            \
+  if (!(cond)) {                                                               \
+    fail(state, seed, #cond);                                                  \
+  }
+
+// Capacities right after game_reset, which later waves must not outgrow
+struct Capacities {
+  size_t aliens, projectiles, barriers, ships;
+};
+
+static Capacities capacities(GameState *state) {
+  GameWorld *world = &state->world;
+  return {world->archetype<AlienArchetype>().capacity(),
+          world->archetype<ProjectileArchetype>().capacity(),
+          world->archetype<BarrierArchetype>().capacity(),
+          world->archetype<ShipArchetype>().capacity()};
+}
+
+// What a tick is checked against from before it ran
+struct Before {
+  uint64_t ticks;
+  Move move;
+  bool step_done;
+};
+
+static Before before_tick(GameState *state) {
+  return {state->time.ticks, state->move,
+          march_step_done(&state->march,
+                          state->world.archetype<AlienArchetype>().size())};
+}
+
+static void check_state(GameState *state, uint64_t seed, const Before *before,
+                        const Capacities *reserved) {
+  GameWorld *world = &state->world;
+  AlienArchetype *aliens = &world->archetype<AlienArchetype>();
+  int num_aliens = aliens->size();
+
+  CHECK(state->time.ticks == before->ticks + 1);
+
+  Capacities now = capacities(state);
+  CHECK(now.aliens == reserved->aliens);
+  CHECK(now.projectiles == reserved->projectiles);
+  CHECK(now.barriers == reserved->barriers);
+  CHECK(now.ships == reserved->ships);
+  CHECK(num_aliens <= stages.header.max_aliens);
+  CHECK(world->archetype<BarrierArchetype>().size() <=
+        stages.header.max_barriers);
+  CHECK(world->archetype<ProjectileArchetype>().size() <= MAX_PROJECTILES);
+  CHECK(world->archetype<ShipArchetype>().size() == 1);
+
+  // find_alien() binary searches the index column
+  uint32_t rows[ALIEN_COLUMNS] = {};
+  const std::vector<Alien> &alien = aliens->column<Alien>();
+  for (int i = 0; i < num_aliens; i++) {
+    CHECK(aliens->alive(i));
+    int index = alien[i].index;
+    CHECK(index >= 0 && index < ALIEN_ROWS * ALIEN_COLUMNS);
+    CHECK(i == 0 || alien[i - 1].index < index);
+    rows[index % ALIEN_COLUMNS] |= 1u << (index / ALIEN_COLUMNS);
+  }
+  CHECK(num_aliens <= state->stage_num_aliens);
+
+  // Only live aliens may be picked to shoot
+  for (int column = 0; column < ALIEN_COLUMNS; column++) {
+    CHECK(state->fire.rows[column] == rows[column]);
+  }
+  CHECK(state->fire.next_tick > state->time.ticks);
+
+  // Kills behind the cursor are only taken off on the next advance
+  const MarchCursor *march = &state->march;
+  CHECK(march->killed >= 0 && march->killed <= march->next);
+  CHECK(march->next - march->killed <= num_aliens);
+  CHECK(march->step_ticks >= 0);
+  CHECK(march->credit >= 0 &&
+        (march->step_ticks == 0 || march->credit < march->step_ticks));
+
+  // The direction only changes between two steps of the formation, or
+  // when a new wave starts over with the cursor at 0
+  CHECK(state->move == before->move || before->step_done || march->next == 0);
+
+  // The edge check turns the formation before it passes PADDING, which
+  // leaves at most one march step of slack on either side
+  const std::vector<Position> &alien_pos = aliens->column<Position>();
+  for (int i = 0; i < num_aliens; i++) {
+    CHECK(alien_pos[i].x >= PADDING - state->march_speed &&
+          alien_pos[i].x <= SCREEN_WIDTH - PADDING + state->march_speed);
+  }
+
+  CHECK(state->move == Move::LEFT || state->move == Move::RIGHT ||
+        state->move == Move::DOWN);
+  CHECK(state->last_shuffle == Move::LEFT ||
+        state->last_shuffle == Move::RIGHT);
+  CHECK(state->lives > 0 || state->game_over);
+  CHECK(state->sounds.count >= 0 && state->sounds.count <= MAX_SOUND_EVENTS);
+  CHECK(state->explosions.count >= 0 &&
+        state->explosions.count <= MAX_EXPLOSIONS);
+  CHECK(state->explosions.head >= 0 &&
+        state->explosions.head < MAX_EXPLOSIONS);
+
+  bool positions_finite = true;
+  bool shots_on_screen = true;
+  world->each<Position>([&](Entity, Position &pos) {
+    positions_finite =
+        positions_finite && std::isfinite(pos.x) && std::isfinite(pos.y);
+  });
+  world->each<Position, Projectile>([&](Entity, Position &pos, Projectile &) {
+    shots_on_screen = shots_on_screen && pos.y >= -SPRITE_SIZE &&
+                      pos.y <= SCREEN_HEIGHT;
+  });
+  CHECK(positions_finite);
+  CHECK(shots_on_screen);
+}
+
+// Plays one case, returns the number of ticks
+static uint64_t run_case(const uint8_t *data, size_t size) {
+  case_data = data;
+  case_size = size;
+
+  uint64_t seed = 0;
+  memcpy(&seed, data, std::min(size, sizeof(seed)));
+  size_t at = std::min(size, sizeof(seed));
+
+  static GameState game;
+  GameState *state = &game;
+  game_reset(state, seed);
+  Capacities reserved = capacities(state);
+  uint64_t ticks = 0;
+
+  for (; at + 1 < size; at += 2) {
+    uint8_t input = data[at] & (INPUT_BUTTONS | INPUT_PRESSED(INPUT_BUTTONS));
+    for (int i = 0; i <= data[at + 1]; i++) {
+      Before before = before_tick(state);
+      state->input = input;
+      // libFuzzer brings its own allocation accounting and is built without
+      // alloc_count.cpp
+#ifndef FUZZ_LIBFUZZER
+      uint64_t allocated = thread_allocations();
+#endif
+      uint64_t start = now_ns();
+      tick(state);
+      tick_ns += now_ns() - start;
+#ifndef FUZZ_LIBFUZZER
+      CHECK(thread_allocations() == allocated);
+#endif
+      check_state(state, seed, &before, &reserved);
+      // Presses only count once, as in the game loop
+      input &= INPUT_BUTTONS;
+      // Nobody plays the sounds
+      state->sounds.count = 0;
+      ticks++;
+
+      if (state->game_over) {
+        seed++;
+        game_reset(state, seed);
+      }
+    }
+  }
+  return ticks;
+}
+
+// Fixed cases for bugs random play is unlikely to hit
+
+// The aliens yet to move in a step are shot before their turn. The step
+// is over then, so the formation at the edge has to turn before it moves
+// again instead of taking another step past it.
+static void regression_turn_after_kills() {
+  static GameState game;
+  GameState *state = &game;
+  uint64_t seed = 1;
+  game_reset(state, seed);
+
+  AlienArchetype *aliens = &state->world.archetype<AlienArchetype>();
+  std::vector<Position> &pos = aliens->column<Position>();
+  // The first row of the first step moves, the rest have not yet
+  tick(state);
+  int moved = state->march.next;
+  CHECK(state->move == Move::RIGHT);
+  CHECK(moved > 0 && moved < int(aliens->size()));
+
+  for (int row = moved; row < int(aliens->size()); row++) {
+    state->world.destroy(state->world.entity<AlienArchetype>(row));
+    fire_scheduler_kill(&state->fire, aliens->column<Alien>()[row].index);
+  }
+  state->world.flush();
+
+  // Whoever is left goes right up to the edge
+  float right = 0;
+  for (const Position &p : pos) {
+    right = std::max(right, p.x);
+  }
+  for (Position &p : pos) {
+    p.x += SCREEN_WIDTH - PADDING - SPRITE_SIZE - right;
+  }
+
+  std::vector<float> x;
+  for (const Position &p : pos) {
+    x.push_back(p.x);
+  }
+  tick(state);
+  CHECK(state->move == Move::DOWN);
+  for (size_t i = 0; i < x.size(); i++) {
+    CHECK(pos[i].x == x[i]);
+  }
+}
+
+static bool load_resources() {
+  if (!load_atlas("Resources/atlas.bin") ||
+      !load_stages("Resources/stages.bin")) {
+    std::cout << "Failed to load Resources/atlas.bin and stages.bin"
+              << std::endl;
+    return false;
+  }
+  build_animations();
+  return true;
+}
+
+#ifdef FUZZ_LIBFUZZER
+extern "C" int LLVMFuzzerInitialize(int *, char ***) {
+  if (!load_resources()) {
+    exit(1);
+  }
+  return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  run_case(data, size);
+  return 0;
+}
+#else
+// Runs of held buttons with the odd tap on top, closer to how people play
+// than uniform bytes
+static std::vector<uint8_t> random_case(Rng *rng) {
+  std::vector<uint8_t> data(sizeof(uint64_t));
+  uint64_t seed = uint64_t(rng_next(rng)) << 32 | rng_next(rng);
+  memcpy(data.data(), &seed, sizeof(seed));
+
+  int runs = 1 + rng_next(rng) % FUZZ_MAX_RUNS;
+  for (int i = 0; i < runs; i++) {
+    uint8_t input = rng_next(rng) & INPUT_BUTTONS;
+    if (rng_next(rng) % 4 == 0) {
+      input |= INPUT_PRESSED(rng_next(rng) & INPUT_BUTTONS);
+    }
+    data.push_back(input);
+    data.push_back(rng_next(rng) % 100);
+  }
+  return data;
+}
+
+int main(int argc, char *args[]) {
+  if (!load_resources()) {
+    return 1;
+  }
+
+  // Replay of saved cases
+  if (argc > 1 && strspn(args[1], "0123456789") != strlen(args[1])) {
+    for (int i = 1; i < argc; i++) {
+      FILE *file = fopen(args[i], "rb");
+      if (!file) {
+        std::cout << "Failed to open " << args[i] << std::endl;
+        return 1;
+      }
+      std::vector<uint8_t> data;
+      int c;
+      while ((c = fgetc(file)) != EOF) {
+        data.push_back(c);
+      }
+      fclose(file);
+      std::cout << args[i] << ": " << run_case(data.data(), data.size())
+                << " ticks" << std::endl;
+    }
+    return 0;
+  }
+
+  regression_turn_after_kills();
+
+  long cases = argc > 1 ? atol(args[1]) : 100;
+  Rng rng;
+  rng_seed(&rng, argc > 2 ? strtoull(args[2], NULL, 10) : 1);
+  save_failures = true;
+
+  uint64_t ticks = 0;
+  uint64_t start = now_ns();
+  for (long i = 0; i < cases; i++) {
+    std::vector<uint8_t> data = random_case(&rng);
+    ticks += run_case(data.data(), data.size());
+  }
+  uint64_t total_ns = now_ns() - start;
+
+  printf("%ld cases, %llu ticks passed\n", cases, (unsigned long long)ticks);
+  printf("tick %.1f ns/tick, %.0f ticks/s with checks\n",
+         double(tick_ns) / ticks, ticks * 1e9 / total_ns);
+  return 0;
+}
+#endif
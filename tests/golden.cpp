@@ -0,0 +1,335 @@
+// Golden image regression tests. Plays seeded, scripted sessions with no
+// window, builds the draw list of chosen ticks the way render() does and
+// compares a hash of the rasterized frame against tests/golden/hashes.txt.
+// The reference frames themselves are kept in tests/golden/frames.sicap
+// (the --capture format), so a mismatch can be shown as a diff image
+// instead of just a hash.
+//
+// What is covered is everything up to and including the draw list: which
+// sprites, barriers, explosions and lives are drawn, in what order, where
+// (with interpolation between ticks) and with which atlas frame, plus the
+// CPU rasterizer. Not covered is the SDL side of render(): the texture
+// blits in draw_sprite(), the barrier point batch, the presenter's scaling
+// and letterbox and the HUD text, which need a window.
+//
+// usage: golden [--update] out_dir
+//
+// --update rewrites both golden files from the current build. On a
+// mismatch the actual, expected and diff images are written to out_dir as
+// <session>-<tick>.ppm, -expected.ppm and -diff.ppm.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../include/stb_image.h"
+
+#include "../src/capture.hpp"
+#include "../src/game.hpp"
+#include "../src/raster.hpp"
+#include "../src/script.hpp"
+
+#define GOLDEN_HASHES "tests/golden/hashes.txt"
+#define GOLDEN_FRAMES "tests/golden/frames.sicap"
+
+struct Session {
+  const char *name;
+  uint64_t seed;
+  // Fraction of a tick past the checked ones that frames are drawn at,
+  // as render() interpolates between ticks
+  float alpha;
+  const ScriptStep *script;
+  int script_steps;
+  // Ticks to check, ascending
+  const int *checks;
+  int check_count;
+};
+
+// Ship never moves, the formation marches down and shoots it
+static const ScriptStep idle_script[] = {{1, 0}};
+static const int idle_checks[] = {0, 1, 120, 600, 1800};
+
+// sweep_script, the benchmark replay
+static const int sweep_checks[] = {30, 90, 200, 400, 800, 1600, 3200};
+
+// Taps fire from under the middle of the formation, for explosions and
+// shots close to the aliens
+static const ScriptStep tap_script[] = {
+    {40, INPUT_RIGHT}, {1, INPUT_SHOOT}, {20, 0}, {1, INPUT_SHOOT}, {20, 0},
+    {40, INPUT_LEFT},  {1, INPUT_SHOOT}, {20, 0}, {1, INPUT_SHOOT}, {20, 0},
+};
+static const int tap_checks[] = {45, 70, 150, 500, 1000};
+
+#define SESSION(name, seed, alpha)                                             \
+  {#name, seed, alpha, name##_script, SCRIPT_STEPS(name##_script),             \
+   name##_checks, int(sizeof(name##_checks) / sizeof(*name##_checks))}
+
+static const Session sessions[] = {
+    SESSION(idle, 1, 1.0f),
+    SESSION(sweep, 7, 0.5f),
+    SESSION(tap, 42, 0.25f),
+};
+
+struct Frame {
+  const Session *session;
+  int tick;
+  uint64_t hash;
+  std::vector<uint32_t> pixels;
+  // What the capture encoder redraws the reference from
+  std::unique_ptr<DrawList> draws;
+};
+
+// FNV-1a over the pixel bytes
+static uint64_t frame_hash(const uint32_t *pixels) {
+  const uint8_t *bytes = (const uint8_t *)pixels;
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t i = 0; i < FRAME_PIXELS * sizeof(uint32_t); i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3;
+  }
+  return hash;
+}
+
+// Runs every session and renders its checked ticks, in the order the
+// golden files list them
+static std::vector<Frame> play_sessions(const uint32_t *sheet,
+                                        int sheet_width) {
+  std::vector<Frame> frames;
+  static GameState game;
+
+  for (const Session &session : sessions) {
+    game_reset(&game, session.seed);
+    int step = 0, step_ticks = 0;
+    int tick_count = 0;
+
+    for (int c = 0; c < session.check_count; c++) {
+      while (tick_count < session.checks[c]) {
+        game.input = session.script[step].input;
+        tick(&game);
+        tick_count++;
+
+        if (++step_ticks == session.script[step].ticks) {
+          step_ticks = 0;
+          step = (step + 1) % session.script_steps;
+        }
+        // Keep going from a fresh game so late checks still see play
+        if (game.game_over) {
+          game_reset(&game, session.seed + tick_count);
+        }
+      }
+
+      Frame frame = {&session, tick_count, 0,
+                     std::vector<uint32_t>(FRAME_PIXELS),
+                     std::make_unique<DrawList>()};
+      draw_list_build(&game, session.alpha, frame.draws.get());
+      raster_draw_list(frame.draws.get(), sheet, sheet_width,
+                       frame.pixels.data());
+      frame.hash = frame_hash(frame.pixels.data());
+      frames.push_back(std::move(frame));
+    }
+  }
+  return frames;
+}
+
+static bool write_golden(const std::vector<Frame> &frames,
+                         const uint32_t *sheet, int sheet_width) {
+  FILE *file = fopen(GOLDEN_HASHES, "w");
+  if (!file) {
+    std::cout << "Failed to open " << GOLDEN_HASHES << std::endl;
+    return false;
+  }
+  for (const Frame &frame : frames) {
+    fprintf(file, "%s %d %016llx\n", frame.session->name, frame.tick,
+            (unsigned long long)frame.hash);
+  }
+  fclose(file);
+
+  static Capture capture;
+  if (!capture_start(&capture, GOLDEN_FRAMES, sheet, sheet_width)) {
+    return false;
+  }
+  for (const Frame &frame : frames) {
+    // Nothing may be dropped here, wait for the encoder to free a slot
+    while (capture.head.load() - capture.tail.load() == CAPTURE_QUEUE) {
+      std::this_thread::yield();
+    }
+    *capture_begin(&capture) = *frame.draws;
+    capture_submit(&capture, frame.tick);
+  }
+  capture_stop(&capture);
+
+  std::cout << "Wrote " << frames.size() << " golden frames" << std::endl;
+  return true;
+}
+
+// Decodes every reference frame, in file order
+static std::vector<std::vector<uint32_t>> read_reference() {
+  std::vector<std::vector<uint32_t>> frames;
+  FILE *file = fopen(GOLDEN_FRAMES, "rb");
+  if (!file) {
+    return frames;
+  }
+
+  CaptureHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, CAPTURE_MAGIC, 4) != 0 ||
+      header.version != CAPTURE_VERSION || header.width != SCREEN_WIDTH ||
+      header.height != SCREEN_HEIGHT) {
+    fclose(file);
+    return frames;
+  }
+
+  std::vector<uint32_t> palette(CAPTURE_PALETTE, 0);
+  std::vector<uint8_t> indices(FRAME_PIXELS, 0);
+  std::vector<uint8_t> data;
+  uint64_t end = header.index_offset ? header.index_offset : UINT64_MAX;
+
+  CaptureRecord record;
+  while ((uint64_t)ftell(file) < end &&
+         fread(&record, sizeof(record), 1, file) == 1) {
+    data.resize(record.size);
+    if (fread(data.data(), 1, record.size, file) != record.size ||
+        record.first_color + record.color_count > CAPTURE_PALETTE) {
+      break;
+    }
+
+    size_t colors = record.color_count * sizeof(uint32_t);
+    memcpy(&palette[record.first_color], data.data(), colors);
+    if (!capture_decode(data.data() + colors, record.size - colors,
+                        indices.data())) {
+      break;
+    }
+
+    std::vector<uint32_t> pixels(FRAME_PIXELS);
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+      pixels[i] = palette[indices[i]];
+    }
+    frames.push_back(std::move(pixels));
+  }
+  fclose(file);
+  return frames;
+}
+
+static void write_ppm(const std::string &path, const uint32_t *pixels) {
+  FILE *out = fopen(path.c_str(), "wb");
+  if (!out) {
+    std::cout << "Failed to open " << path << std::endl;
+    return;
+  }
+  fprintf(out, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+  for (int i = 0; i < FRAME_PIXELS; i++) {
+    uint8_t rgb[3] = {uint8_t(pixels[i]), uint8_t(pixels[i] >> 8),
+                      uint8_t(pixels[i] >> 16)};
+    fwrite(rgb, 1, 3, out);
+  }
+  fclose(out);
+}
+
+// The expected frame dimmed to grey, with every pixel that differs in red.
+// Returns the number of differing pixels.
+static int write_diff(const std::string &path, const uint32_t *actual,
+                      const uint32_t *expected) {
+  std::vector<uint32_t> diff(FRAME_PIXELS);
+  int count = 0;
+  for (int i = 0; i < FRAME_PIXELS; i++) {
+    if (actual[i] != expected[i]) {
+      diff[i] = rgba(255, 0, 0, 255);
+      count++;
+    } else {
+      uint32_t c = expected[i];
+      uint8_t grey =
+          ((c & 0xFF) + (c >> 8 & 0xFF) + (c >> 16 & 0xFF)) / 3 / 4;
+      diff[i] = rgba(grey, grey, grey, 255);
+    }
+  }
+  write_ppm(path, diff.data());
+  return count;
+}
+
+int main(int argc, char *args[]) {
+  bool update = argc > 1 && strcmp(args[1], "--update") == 0;
+  const char *out_dir = argc > 1 + update ? args[1 + update] : ".";
+
+  stbi_set_flip_vertically_on_load(true);
+  int width, height, channels;
+  unsigned char *sheet =
+      stbi_load("Resources/atlas.png", &width, &height, &channels, 4);
+  if (!sheet || !load_atlas("Resources/atlas.bin") ||
+      !load_stages("Resources/stages.bin")) {
+    std::cout << "Failed to load Resources/atlas.png, atlas.bin and stages.bin"
+              << std::endl;
+    return 1;
+  }
+  build_animations();
+
+  std::vector<Frame> frames = play_sessions((const uint32_t *)sheet, width);
+
+  if (update) {
+    bool ok = write_golden(frames, (const uint32_t *)sheet, width);
+    stbi_image_free(sheet);
+    return ok ? 0 : 1;
+  }
+  stbi_image_free(sheet);
+
+  FILE *file = fopen(GOLDEN_HASHES, "r");
+  if (!file) {
+    std::cout << "Failed to open " << GOLDEN_HASHES
+              << ", run with --update to create it" << std::endl;
+    return 1;
+  }
+  std::vector<std::vector<uint32_t>> reference = read_reference();
+
+  int failed = 0;
+  size_t i = 0;
+  char name[32];
+  int golden_tick;
+  unsigned long long golden_hash;
+  while (fscanf(file, "%31s %d %llx", name, &golden_tick, &golden_hash) ==
+         3) {
+    if (i == frames.size() || strcmp(name, frames[i].session->name) != 0 ||
+        golden_tick != frames[i].tick) {
+      std::cout << "Golden frames do not match the sessions, run with "
+                   "--update"
+                << std::endl;
+      fclose(file);
+      return 1;
+    }
+
+    const Frame &frame = frames[i];
+    if (frame.hash != golden_hash) {
+      failed++;
+      std::string base = std::string(out_dir) + "/" + name + "-" +
+                         std::to_string(frame.tick);
+      write_ppm(base + ".ppm", frame.pixels.data());
+      std::cout << "FAIL " << name << " tick " << frame.tick;
+      if (i < reference.size()) {
+        write_ppm(base + "-expected.ppm", reference[i].data());
+        int pixels = write_diff(base + "-diff.ppm", frame.pixels.data(),
+                                reference[i].data());
+        std::cout << ": " << pixels << " pixels differ, see " << base
+                  << "-diff.ppm";
+      } else {
+        std::cout << ": no reference frame, see " << base << ".ppm";
+      }
+      std::cout << std::endl;
+    }
+    i++;
+  }
+  fclose(file);
+
+  if (i != frames.size()) {
+    std::cout << "Golden frames do not match the sessions, run with --update"
+              << std::endl;
+    return 1;
+  }
+
+  std::cout << frames.size() - failed << "/" << frames.size()
+            << " golden frames match" << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+// Cuts the sprites the game uses out of the 16x16 spritesheet, trims them to
+// their opaque pixels and packs them into a small atlas. Writes the atlas as
+// a PNG plus atlas.bin holding the frame rects, animation table and the
+// 1-bit collision masks (see src/atlas.hpp).
+//
+// usage: atlas_packer spritesheet.png atlas.png atlas.bin
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../include/stb_image.h"
+
+#include "../src/atlas.hpp"
+
+// Pixels below this alpha are guide lines in the sheet, not sprite pixels
+#define ALPHA_THRESHOLD 128
+#define ATLAS_PADDING 1
+
+struct Cell {
+  int x, y;
+};
+
+struct SpriteSource {
+  SpriteId id;
+  uint16_t frame_ticks;
+  std::vector<Cell> cells;
+};
+
+// Cell coordinates match the sheet loaded bottom-up, as the game does.
+// Frame ticks assume 60 ticks per second.
+static const std::vector<SpriteSource> sources = {
+    {SPRITE_SHIP, 0, {{0, 0}}},
+    {SPRITE_ALIEN_CYAN, 0, {{3, 0}}},
+    {SPRITE_ALIEN_RED, 0, {{2, 0}}},
+    {SPRITE_ALIEN_YELLOW, 0, {{2, 1}}},
+    {SPRITE_ALIEN_WHITE, 0, {{1, 0}}},
+    {SPRITE_PROJECTILE, 4, {{1, 1}, {1, 2}}},
+    {SPRITE_EXPLOSION, 15, {{0, 1}, {0, 2}}},
+    {SPRITE_BARRIER, 0, {{0, 3}}},
+};
+
+static uint32_t crc32(const unsigned char *data, size_t size, uint32_t crc) {
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+static void put_u32(std::vector<unsigned char> *out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out->push_back((value >> shift) & 0xFF);
+  }
+}
+
+static void put_chunk(FILE *file, const char *type,
+                      const std::vector<unsigned char> &data) {
+  std::vector<unsigned char> chunk;
+  put_u32(&chunk, data.size());
+  chunk.insert(chunk.end(), type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+  put_u32(&chunk, crc32(chunk.data() + 4, chunk.size() - 4, 0));
+  fwrite(chunk.data(), 1, chunk.size(), file);
+}
+
+// Minimal RGBA PNG writer using uncompressed deflate blocks. The atlas is a
+// few KB, so compression is not worth a dependency.
+static bool write_png(const char *path, const unsigned char *rgba, int width,
+                      int height) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+
+  static const unsigned char signature[8] = {137, 'P', 'N', 'G',
+                                             13,  10,  26,  10};
+  fwrite(signature, 1, 8, file);
+
+  std::vector<unsigned char> header;
+  put_u32(&header, width);
+  put_u32(&header, height);
+  header.insert(header.end(), {8, 6, 0, 0, 0});
+  put_chunk(file, "IHDR", header);
+
+  std::vector<unsigned char> raw;
+  for (int y = 0; y < height; y++) {
+    raw.push_back(0);
+    raw.insert(raw.end(), rgba + y * width * 4, rgba + (y + 1) * width * 4);
+  }
+
+  std::vector<unsigned char> zlib = {0x78, 0x01};
+  uint32_t a = 1, b = 0;
+  for (size_t pos = 0; pos < raw.size() || pos == 0;) {
+    size_t len = std::min<size_t>(raw.size() - pos, 65535);
+    zlib.push_back(pos + len == raw.size() ? 1 : 0);
+    zlib.insert(zlib.end(), {(unsigned char)(len & 0xFF),
+                             (unsigned char)(len >> 8),
+                             (unsigned char)(~len & 0xFF),
+                             (unsigned char)((~len >> 8) & 0xFF)});
+    zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + len);
+    pos += len;
+    if (len == 0) {
+      break;
+    }
+  }
+  for (unsigned char byte : raw) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  put_u32(&zlib, (b << 16) | a);
+  put_chunk(file, "IDAT", zlib);
+  put_chunk(file, "IEND", {});
+
+  return fclose(file) == 0;
+}
+
+int main(int argc, char *args[]) {
+  if (argc != 4) {
+    std::cout << "usage: " << args[0]
+              << " spritesheet.png atlas.png atlas.bin" << std::endl;
+    return 1;
+  }
+
+  stbi_set_flip_vertically_on_load(true);
+
+  int width, height, channels;
+  unsigned char *sheet = stbi_load(args[1], &width, &height, &channels, 4);
+
+  if (!sheet) {
+    std::cout << "Failed to load " << args[1] << std::endl;
+    return 1;
+  }
+
+  std::vector<AtlasSprite> sprites(SPRITE_COUNT);
+  std::vector<AtlasFrame> frames;
+  std::vector<Cell> frame_cells;
+
+  for (const SpriteSource &source : sources) {
+    sprites[source.id] = {(uint16_t)frames.size(),
+                          (uint16_t)source.cells.size(), source.frame_ticks};
+
+    for (Cell cell : source.cells) {
+      AtlasFrame frame = {};
+      int min_x = SPRITE_SIZE, min_y = SPRITE_SIZE, max_x = 0, max_y = 0;
+
+      for (int y = 0; y < SPRITE_SIZE; y++) {
+        for (int x = 0; x < SPRITE_SIZE; x++) {
+          int px = cell.x * SPRITE_SIZE + x;
+          int py = cell.y * SPRITE_SIZE + y;
+          if (sheet[(py * width + px) * 4 + 3] < ALPHA_THRESHOLD) {
+            continue;
+          }
+
+          frame.mask[y] |= uint16_t(1 << x);
+          min_x = std::min(min_x, x);
+          min_y = std::min(min_y, y);
+          max_x = std::max(max_x, x + 1);
+          max_y = std::max(max_y, y + 1);
+        }
+      }
+
+      if (max_x == 0) {
+        std::cout << "Cell " << cell.x << "," << cell.y << " is empty"
+                  << std::endl;
+        return 1;
+      }
+
+      frame.offset_x = min_x;
+      frame.offset_y = min_y;
+      frame.w = max_x - min_x;
+      frame.h = max_y - min_y;
+      frames.push_back(frame);
+      frame_cells.push_back(cell);
+    }
+  }
+
+  // Shelf packing, tallest frames first. Try every power of two width and
+  // keep the smallest atlas.
+  std::vector<int> order(frames.size());
+  for (int i = 0; i < (int)order.size(); i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    return frames[a].h != frames[b].h ? frames[a].h > frames[b].h
+                                      : frames[a].w > frames[b].w;
+  });
+
+  int atlas_width = 0, atlas_height = 0;
+  for (int try_width = SPRITE_SIZE; try_width <= width * 4; try_width *= 2) {
+    std::vector<AtlasFrame> packed = frames;
+    int x = 0, y = 0, shelf = 0;
+
+    for (int i : order) {
+      AtlasFrame *frame = &packed[i];
+      if (x + frame->w > try_width) {
+        x = 0;
+        y += shelf + ATLAS_PADDING;
+        shelf = 0;
+      }
+      frame->x = x;
+      frame->y = y;
+      x += frame->w + ATLAS_PADDING;
+      shelf = std::max(shelf, (int)frame->h);
+    }
+
+    int try_height = y + shelf;
+    if (atlas_width == 0 ||
+        try_width * try_height < atlas_width * atlas_height) {
+      atlas_width = try_width;
+      atlas_height = try_height;
+      frames = packed;
+    }
+  }
+
+  std::vector<unsigned char> pixels(atlas_width * atlas_height * 4, 0);
+  for (size_t i = 0; i < frames.size(); i++) {
+    const AtlasFrame &frame = frames[i];
+    for (int y = 0; y < frame.h; y++) {
+      for (int x = 0; x < frame.w; x++) {
+        int sx = frame_cells[i].x * SPRITE_SIZE + frame.offset_x + x;
+        int sy = frame_cells[i].y * SPRITE_SIZE + frame.offset_y + y;
+        if (!(frame.mask[frame.offset_y + y] >> (frame.offset_x + x) & 1)) {
+          continue;
+        }
+        memcpy(&pixels[((frame.y + y) * atlas_width + frame.x + x) * 4],
+               &sheet[(sy * width + sx) * 4], 4);
+      }
+    }
+  }
+
+  // Frame rects are bottom-up like the loaded sheet; store the PNG top-down
+  // so it reads normally and the game's flip on load restores the layout.
+  std::vector<unsigned char> flipped(pixels.size());
+  for (int y = 0; y < atlas_height; y++) {
+    memcpy(&flipped[(atlas_height - 1 - y) * atlas_width * 4],
+           &pixels[y * atlas_width * 4], atlas_width * 4);
+  }
+
+  if (!write_png(args[2], flipped.data(), atlas_width, atlas_height)) {
+    std::cout << "Failed to write " << args[2] << std::endl;
+    return 1;
+  }
+
+  AtlasHeader header = {{'S', 'I', 'A', 'T'},
+                        ATLAS_VERSION,
+                        (uint16_t)sprites.size(),
+                        (uint16_t)frames.size(),
+                        (uint16_t)atlas_width,
+                        (uint16_t)atlas_height};
+
+  FILE *file = fopen(args[3], "wb");
+  if (!file) {
+    std::cout << "Failed to write " << args[3] << std::endl;
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, file);
+  fwrite(sprites.data(), sizeof(AtlasSprite), sprites.size(), file);
+  fwrite(frames.data(), sizeof(AtlasFrame), frames.size(), file);
+  fclose(file);
+
+  std::cout << "Packed " << frames.size() << " frames into " << atlas_width
+            << "x" << atlas_height << " (sheet was " << width << "x"
+            << height << ")" << std::endl;
+
+  stbi_image_free(sheet);
+  return 0;
+}
@@ -0,0 +1,100 @@
+// Headless benchmark suite. Plays a scripted replay through the simulation
+// with no window and times the systems the game runs every frame. It is
+// also the training workload for the PGO build (make pgo).
+//
+// usage: bench [ticks]
+//
+// Prints one "name value unit" line per benchmark.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../include/stb_image.h"
+
+#include "../src/game.hpp"
+#include "../src/raster.hpp"
+#include "../src/script.hpp"
+
+struct Replay {
+  GameState game;
+  uint64_t seed;
+  int step;
+  int step_ticks;
+};
+
+static void replay_reset(Replay *replay, uint64_t seed) {
+  replay->seed = seed;
+  replay->step = 0;
+  replay->step_ticks = 0;
+  game_reset(&replay->game, seed);
+}
+
+// One tick of the replay, restarting with the next seed when the game
+// ends
+static void replay_advance(Replay *replay) {
+  const ScriptStep *step = &sweep_script[replay->step];
+  GameState *game = &replay->game;
+  game->input = step->input;
+
+  tick(game);
+
+  if (++replay->step_ticks == step->ticks) {
+    replay->step_ticks = 0;
+    replay->step = (replay->step + 1) % SCRIPT_STEPS(sweep_script);
+  }
+
+  if (game->game_over) {
+    replay_reset(replay, replay->seed + 1);
+  }
+}
+
+static uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int main(int argc, char *args[]) {
+  long ticks = argc > 1 ? atol(args[1]) : 100000;
+
+  stbi_set_flip_vertically_on_load(true);
+  int width, height, channels;
+  unsigned char *sheet =
+      stbi_load("Resources/atlas.png", &width, &height, &channels, 4);
+  if (!sheet || !load_atlas("Resources/atlas.bin") ||
+      !load_stages("Resources/stages.bin")) {
+    printf("Failed to load Resources/atlas.png, atlas.bin and stages.bin\n");
+    return 1;
+  }
+  build_animations();
+
+  static Replay replay;
+
+  // Simulation alone
+  replay_reset(&replay, 1);
+  uint64_t start = now_ns();
+  for (long i = 0; i < ticks; i++) {
+    replay_advance(&replay);
+  }
+  printf("replay %.1f ns/tick\n", double(now_ns() - start) / ticks);
+
+  // CPU render path, a frame every tick of the same replay
+  std::vector<uint32_t> pixels(FRAME_PIXELS);
+  long frames = ticks / 10;
+  uint64_t raster_ns = 0;
+  replay_reset(&replay, 1);
+  for (long i = 0; i < frames; i++) {
+    replay_advance(&replay);
+    start = now_ns();
+    raster_frame(&replay.game, (const uint32_t *)sheet, width, pixels.data());
+    raster_ns += now_ns() - start;
+  }
+  printf("raster %.1f ns/frame\n", double(raster_ns) / frames);
+
+  stbi_image_free(sheet);
+  return 0;
+}
@@ -0,0 +1,110 @@
+// Pulls single frames out of a capture recorded with --capture. Seeks to the
+// closest keyframe through the index and decodes forward from there. Files
+// without an index (the game did not shut down cleanly) are scanned from
+// the start.
+//
+// usage: capture_extract capture.sicap frame out.ppm
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "../src/capture.hpp"
+
+int main(int argc, char *args[]) {
+  if (argc != 4) {
+    std::cout << "usage: capture_extract capture.sicap frame out.ppm"
+              << std::endl;
+    return 1;
+  }
+
+  uint64_t target = strtoull(args[2], NULL, 10);
+
+  FILE *file = fopen(args[1], "rb");
+  if (!file) {
+    std::cout << "Failed to open " << args[1] << std::endl;
+    return 1;
+  }
+
+  CaptureHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, CAPTURE_MAGIC, 4) != 0 ||
+      header.version != CAPTURE_VERSION || header.width != SCREEN_WIDTH ||
+      header.height != SCREEN_HEIGHT) {
+    std::cout << "Invalid or outdated capture " << args[1] << std::endl;
+    return 1;
+  }
+
+  // The last keyframe at or before the target, or the first record
+  long start = sizeof(CaptureHeader);
+  if (header.index_offset) {
+    fseek(file, header.index_offset, SEEK_SET);
+    uint32_t count = 0;
+    if (fread(&count, sizeof(count), 1, file) == 1) {
+      std::vector<CaptureIndexEntry> index(count);
+      if (fread(index.data(), sizeof(CaptureIndexEntry), count, file) ==
+          count) {
+        for (const CaptureIndexEntry &entry : index) {
+          if (entry.frame <= target) {
+            start = entry.offset;
+          }
+        }
+      }
+    }
+  }
+  fseek(file, start, SEEK_SET);
+
+  std::vector<uint32_t> palette(CAPTURE_PALETTE, 0);
+  std::vector<uint8_t> indices(FRAME_PIXELS, 0);
+  std::vector<uint8_t> data;
+  bool found = false;
+
+  // Records end where the index starts
+  uint64_t end = header.index_offset ? header.index_offset : UINT64_MAX;
+
+  CaptureRecord record;
+  while ((uint64_t)ftell(file) < end &&
+         fread(&record, sizeof(record), 1, file) == 1) {
+    data.resize(record.size);
+    if (fread(data.data(), 1, record.size, file) != record.size ||
+        record.first_color + record.color_count > CAPTURE_PALETTE) {
+      break;
+    }
+
+    size_t colors = record.color_count * sizeof(uint32_t);
+    memcpy(&palette[record.first_color], data.data(), colors);
+    if (!capture_decode(data.data() + colors, record.size - colors,
+                        indices.data())) {
+      std::cout << "Corrupt record for frame " << record.frame << std::endl;
+      return 1;
+    }
+
+    if (record.frame == target) {
+      found = true;
+      break;
+    }
+  }
+  fclose(file);
+
+  if (!found) {
+    std::cout << "Frame " << target << " is not in the capture" << std::endl;
+    return 1;
+  }
+
+  FILE *out = fopen(args[3], "wb");
+  if (!out) {
+    std::cout << "Failed to open " << args[3] << std::endl;
+    return 1;
+  }
+  fprintf(out, "P6\n%d %d\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+  for (int i = 0; i < FRAME_PIXELS; i++) {
+    uint32_t color = palette[indices[i]];
+    uint8_t rgb[3] = {uint8_t(color), uint8_t(color >> 8),
+                      uint8_t(color >> 16)};
+    fwrite(rgb, 1, 3, out);
+  }
+  fclose(out);
+  return 0;
+}
@@ -0,0 +1,160 @@
+// Turns the text stage list into the stages.bin the game loads (see
+// src/stage.hpp). The format of the text file is described at the top of
+// Resources/stages.txt.
+//
+// usage: stage_packer stages.txt stages.bin
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/fire.hpp"
+#include "../src/stage.hpp"
+
+static bool fail(int line, const std::string &message) {
+  std::cout << "line " << line << ": " << message << std::endl;
+  return false;
+}
+
+static bool parse(std::ifstream &in, std::vector<StageDef> *defs) {
+  StageDef def;
+  std::vector<std::string> rows;
+  bool in_stage = false;
+  std::string text;
+  int line = 0;
+
+  while (std::getline(in, text)) {
+    line++;
+    std::istringstream words(text);
+    std::string key;
+    if (!(words >> key) || key[0] == '#') {
+      continue;
+    }
+
+    if (key == "stage") {
+      if (in_stage) {
+        return fail(line, "stage inside a stage");
+      }
+      in_stage = true;
+      def = {};
+      def.march_speed = 3;
+      def.fire_mean_ticks = 20;
+      def.bottom_y = 156;
+      def.barrier_rows = 2;
+      rows.clear();
+    } else if (!in_stage) {
+      return fail(line, "expected stage");
+    } else if (key == "speed" || key == "fire" || key == "bottom" ||
+               key == "barriers") {
+      int value;
+      if (!(words >> value)) {
+        return fail(line, "missing value for " + key);
+      }
+      if (key == "speed") {
+        // 0 would freeze the formation
+        if (value < 1 || value > 255) {
+          return fail(line, "speed must be 1 to 255");
+        }
+        def.march_speed = value;
+      } else if (key == "fire") {
+        // Shots are never closer than FIRE_MIN_TICKS anyway
+        if (value < FIRE_MIN_TICKS || value > 255) {
+          return fail(line, "fire must be " + std::to_string(FIRE_MIN_TICKS) +
+                                " to 255");
+        }
+        def.fire_mean_ticks = value;
+      } else if (key == "bottom") {
+        def.bottom_y = value;
+      } else if (value < 0 || value > MAX_BARRIER_ROWS) {
+        return fail(line, "barriers must be 0 to 2");
+      } else {
+        def.barrier_rows = value;
+      }
+    } else if (key == "end") {
+      if (rows.empty() || rows.size() > ALIEN_ROWS) {
+        return fail(line, "a stage needs 1 to 3 rows");
+      }
+
+      memset(def.types, STAGE_EMPTY, sizeof(def.types));
+      for (size_t r = 0; r < rows.size(); r++) {
+        // Listed top row first, stored from the ship up
+        const std::string &cells = rows[rows.size() - 1 - r];
+        for (size_t c = 0; c < cells.size(); c++) {
+          uint8_t type;
+          switch (cells[c]) {
+          case 'C': type = CYAN; break;
+          case 'R': type = RED; break;
+          case 'Y': type = YELLOW; break;
+          case 'W': type = WHITE; break;
+          case '?': type = STAGE_RANDOM; break;
+          case '.': type = STAGE_EMPTY; break;
+          default:
+            return fail(line, std::string("unknown cell ") + cells[c]);
+          }
+          def.types[r][c] = type;
+          def.alien_count += type != STAGE_EMPTY;
+        }
+      }
+
+      if (def.alien_count == 0) {
+        return fail(line, "a stage needs at least one alien");
+      }
+      defs->push_back(def);
+      in_stage = false;
+    } else if (key.size() == ALIEN_COLUMNS) {
+      rows.push_back(key);
+    } else {
+      return fail(line, "rows need exactly 10 cells: " + key);
+    }
+  }
+
+  if (in_stage) {
+    return fail(line, "missing end");
+  }
+  return !defs->empty() || fail(line, "no stages");
+}
+
+int main(int argc, char *args[]) {
+  if (argc != 3) {
+    std::cout << "usage: stage_packer stages.txt stages.bin" << std::endl;
+    return 1;
+  }
+
+  std::ifstream in(args[1]);
+  if (!in) {
+    std::cout << "Failed to open " << args[1] << std::endl;
+    return 1;
+  }
+
+  std::vector<StageDef> defs;
+  if (!parse(in, &defs)) {
+    return 1;
+  }
+
+  StageHeader header = {};
+  memcpy(header.magic, STAGE_MAGIC, 4);
+  header.version = STAGE_VERSION;
+  header.stage_count = defs.size();
+  for (const StageDef &def : defs) {
+    header.max_aliens = std::max<int>(header.max_aliens, def.alien_count);
+    header.max_barriers =
+        std::max<int>(header.max_barriers, def.barrier_rows * BARRIER_COLUMNS);
+  }
+
+  FILE *out = fopen(args[2], "wb");
+  if (!out) {
+    std::cout << "Failed to open " << args[2] << std::endl;
+    return 1;
+  }
+  fwrite(&header, sizeof(header), 1, out);
+  fwrite(defs.data(), sizeof(StageDef), defs.size(), out);
+  fclose(out);
+
+  std::cout << "Packed " << defs.size() << " stages" << std::endl;
+  return 0;
+}